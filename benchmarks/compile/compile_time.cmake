@@ -0,0 +1,19 @@
+# Times a rebuild of the compile-time benchmark targets, run by the compile_time_benchmark target:
+#   cmake -DBUILD_DIR=<dir> -DUNITS_DIR=<dir> "-DTARGETS=<target>;..." -P compile_time.cmake
+# The units are touched before every build, so each target recompiles all of them on one job.
+
+file(GLOB units ${UNITS_DIR}/*.cpp)
+execute_process(COMMAND ${CMAKE_COMMAND} --build ${BUILD_DIR} --target liberrc_instances OUTPUT_QUIET)
+foreach (target ${TARGETS})
+    # First build outside the timing, so precompiled headers and dependencies are up to date
+    execute_process(COMMAND ${CMAKE_COMMAND} --build ${BUILD_DIR} --target ${target} OUTPUT_QUIET)
+    file(TOUCH ${units})
+    execute_process(COMMAND ${CMAKE_COMMAND} -E time ${CMAKE_COMMAND} --build ${BUILD_DIR} --target ${target}
+                            --parallel 1
+                    OUTPUT_VARIABLE output RESULT_VARIABLE result)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "Building ${target} failed:\n${output}")
+    endif()
+    string(REGEX MATCH "Elapsed time: [0-9.]+ s" elapsed "${output}")
+    message(STATUS "${target}: ${elapsed}")
+endforeach()
@@ -0,0 +1,148 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "alloc_counter.h"
+#include "errc.h"
+#include "errc_propagate.h"
+#include "errc_poly.h"
+#include "errc_units.h"
+
+using EV = ErrorValue<double, double>;
+
+// Reports operator new calls per iteration next to the timing
+void reportAllocations(benchmark::State &state, std::size_t before) {
+    state.counters["allocs/iter"] = benchmark::Counter(static_cast<double>(allocations() - before),
+                                                       benchmark::Counter::kAvgIterations);
+}
+
+static void BM_Arithmetic(benchmark::State &state) {
+    EV a(1.5, 0.1), b(2.5, 0.2), r(0, 0);
+    std::size_t before = allocations();
+    for (auto _ : state) {
+        r = a*b + a/b - r*0.5;
+        benchmark::DoNotOptimize(r);
+    }
+    reportAllocations(state, before);
+}
+BENCHMARK(BM_Arithmetic);
+
+// Same operations as BM_Arithmetic, with the dimensions checked during compilation
+static void BM_ArithmeticUnits(benchmark::State &state) {
+    using namespace liberrc::units;
+    Quantity<Metre> a(1.5, 0.1), r(0, 0);
+    Quantity<One> b(2.5, 0.2);
+    std::size_t before = allocations();
+    for (auto _ : state) {
+        r = a*b + a/b - r*0.5;
+        benchmark::DoNotOptimize(r);
+    }
+    reportAllocations(state, before);
+}
+BENCHMARK(BM_ArithmeticUnits);
+
+static void BM_ArithmeticCustomDefaultError(benchmark::State &state) {
+    EV a(1.5, 0.1), b(2.5, 0.2), r(0, 0);
+    std::array<double, 16> table{};
+    a.setDefaultErrorCalculationMethod(EV::DEF_ERROR_FUNC, [table](double) { return table[0]; });
+    std::size_t before = allocations();
+    for (auto _ : state) {
+        r = a*b + a*2.0 - b;
+        benchmark::DoNotOptimize(r);
+    }
+    reportAllocations(state, before);
+}
+BENCHMARK(BM_ArithmeticCustomDefaultError);
+
+static void BM_Errmath(benchmark::State &state) {
+    EV x(0.5, 0.01), y(1.5, 0.02), r(0, 0);
+    std::size_t before = allocations();
+    for (auto _ : state) {
+        r = sqrt(x*y) + pow(x, y) + sin(x) + exp(y);
+        benchmark::DoNotOptimize(r);
+    }
+    reportAllocations(state, before);
+}
+BENCHMARK(BM_Errmath);
+
+// Same function as BM_Errmath, evaluated once in dual arithmetic
+static void BM_ErrmathPropagate(benchmark::State &state) {
+    EV x(0.5, 0.01), y(1.5, 0.02), r(0, 0);
+    auto f = [](auto a, auto b) {
+        using std::sqrt, std::pow, std::sin, std::exp;
+        return sqrt(a*b) + pow(a, b) + sin(a) + exp(b);
+    };
+    std::size_t before = allocations();
+    for (auto _ : state) {
+        r = liberrc::propagate(f, x, y);
+        benchmark::DoNotOptimize(r);
+    }
+    reportAllocations(state, before);
+}
+BENCHMARK(BM_ErrmathPropagate);
+
+// Degree 8 calibration curve, chained ErrorValue arithmetic against one Horner pass
+static std::vector<EV> calibration() {
+    std::vector<EV> c;
+    for (int k = 0; k < 9; ++k)
+        c.emplace_back(1.0/(k + 1), 0.001*(k + 1));
+    return c;
+}
+
+static void BM_PolynomialChained(benchmark::State &state) {
+    std::vector<EV> c = calibration();
+    EV x(0.7, 0.01), r(0, 0);
+    for (auto _ : state) {
+        r = c.back();
+        for (std::size_t k = c.size() - 1; k-- > 0;)
+            r = r*x + c[k];
+        benchmark::DoNotOptimize(r);
+    }
+}
+BENCHMARK(BM_PolynomialChained);
+
+static void BM_Polyval(benchmark::State &state) {
+    std::vector<EV> c = calibration();
+    EV x(0.7, 0.01), r(0, 0);
+    for (auto _ : state) {
+        r = liberrc::polyval(c, x);
+        benchmark::DoNotOptimize(r);
+    }
+}
+BENCHMARK(BM_Polyval);
+
+static void BM_PolyvalBatch(benchmark::State &state) {
+    liberrc::ErrorArray<double> c, x(static_cast<std::size_t>(state.range(0))), r(x.size());
+    for (const EV &ev : calibration())
+        c.push_back(ev);
+    for (std::size_t i = 0; i < x.size(); ++i)
+        x.set(i, 0.001*i, 0.01);
+    for (auto _ : state) {
+        liberrc::poly::polyval(c.value.data(), c.error.data(), c.size(), x.value.data(), x.error.data(),
+                               r.value.data(), r.error.data(), x.size());
+        benchmark::DoNotOptimize(r.value.data());
+    }
+    state.SetItemsProcessed(state.iterations()*state.range(0));
+}
+BENCHMARK(BM_PolyvalBatch)->Arg(4096);
+
+BENCHMARK_MAIN();
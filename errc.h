@@ -20,10 +20,29 @@
 #define LIBERRC_ERRC_H
 
 #include <type_traits>
+#include <functional>
 #include <iomanip>
 #include <ostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <cmath>
 
+#ifdef LIBERRC_INSTRUMENT
+#include "errc_instrument.h"
+#define LIBERRC_COUNT(op) liberrc::instrument::count(liberrc::instrument::Op::op)
+#define LIBERRC_TRACE(op, res, ...) liberrc::instrument::trace(liberrc::instrument::Op::op, res, __VA_ARGS__)
+#define LIBERRC_TRACE_UNARY(op, x, ...) liberrc::instrument::traceUnary(liberrc::instrument::Op::op, x, __VA_ARGS__)
+#define LIBERRC_TRACE_GRADIENT(op, res, ...) \
+        liberrc::instrument::traceGradient(liberrc::instrument::Op::op, res, __VA_ARGS__)
+#else
+#define LIBERRC_COUNT(op) ((void)0)
+#define LIBERRC_TRACE(op, res, ...) ((void)0)
+#define LIBERRC_TRACE_UNARY(op, x, ...) (__VA_ARGS__)
+#define LIBERRC_TRACE_GRADIENT(op, res, ...) ((void)0)
+#endif
+
 #ifdef LIBERRC_CPP2A_SUPPORT
 #include <compare>
 #include <concepts>
@@ -54,10 +73,15 @@ public:
     T value;
     E error;
 
+#ifdef LIBERRC_INSTRUMENT
+    liberrc::instrument::Budget budget;
+#endif
+
     //------- CONSTRUCTORS -------
 
     [[nodiscard]] ErrorValue() = default;
     [[nodiscard]] ErrorValue(const ErrorValue &ev) = default;
+    [[nodiscard]] ErrorValue(ErrorValue &&ev) noexcept = default;
     [[nodiscard]] ErrorValue(T value_, E error_) : value(value_), error(error_) {};
 
     //------- ASSIGMENT OPERATORS -------
@@ -65,6 +89,9 @@ public:
     ErrorValue& operator=(const ErrorValue &ev) {
         if (&ev != this) {
             value = ev.value, error = ev.error;
+#ifdef LIBERRC_INSTRUMENT
+            budget = ev.budget;
+#endif
         }
         return *this;
     }
@@ -72,34 +99,40 @@ public:
     ErrorValue& operator=(T value_) {
         value = value_;
         error = defaultNumberError(value_);
+#ifdef LIBERRC_INSTRUMENT
+        budget.clear();
+#endif
           return *this;
     }
 
     //------- COMPOUND ASSIGMENT OPERATORS -------
 
-    ErrorValue operator+=(const ErrorValue &ev) {
+    ErrorValue& operator+=(const ErrorValue &ev) {
+        LIBERRC_TRACE(ADD, *this, *this, 1, ev, 1);
         value += ev.value;
         error = sqrt(error*error + ev.error*ev.error);
         return *this;
     }
 
-    ErrorValue operator+=(T value_) {
+    ErrorValue& operator+=(T value_) {
         *this += ErrorValue(value_, defaultNumberError(value_));
         return *this;
     }
 
-    ErrorValue operator-=(const ErrorValue &ev) {
+    ErrorValue& operator-=(const ErrorValue &ev) {
+        LIBERRC_TRACE(SUB, *this, *this, 1, ev, 1);
         value -= ev.value;
         error = sqrt(error*error + ev.error*ev.error);
         return *this;
     }
 
-    ErrorValue operator-=(T value_) {
+    ErrorValue& operator-=(T value_) {
         *this -= ErrorValue(value_, defaultNumberError(value_));
         return *this;
     }
 
-    ErrorValue operator*=(const ErrorValue &ev) {
+    ErrorValue& operator*=(const ErrorValue &ev) {
+        LIBERRC_TRACE(MUL, *this, *this, 1.0*ev.value*ev.value, ev, 1.0*value*value);
         E e1 = error/value;
         E e2 = ev.error/ev.value;
         value *= ev.value;
@@ -107,12 +140,13 @@ public:
         return *this;
     }
 
-    ErrorValue operator*=(T value_) {
+    ErrorValue& operator*=(T value_) {
         *this *= ErrorValue(value_, defaultNumberError(value_));
         return *this;
     }
 
-    ErrorValue operator/=(const ErrorValue &ev) {
+    ErrorValue& operator/=(const ErrorValue &ev) {
+        LIBERRC_TRACE(DIV, *this, *this, 1.0/(ev.value*ev.value), ev, 1.0*value*value/(ev.value*ev.value*ev.value*ev.value));
         E e1 = error/value;
         E e2 = ev.error/ev.value;
         value /= ev.value;
@@ -120,70 +154,116 @@ public:
         return *this;
     }
 
-    ErrorValue operator/=(T value_) {
+    ErrorValue& operator/=(T value_) {
         *this /= ErrorValue(value_, defaultNumberError(value_));
         return *this;
     }
 
     //------- ARITHMETIC OPERATORS -------
 
-    ErrorValue operator+(const ErrorValue &ev) const {
+    ErrorValue operator+(const ErrorValue &ev) const & {
         ErrorValue res = *this;
         res += ev;
         return res;
     }
 
-    ErrorValue operator+(const T &value_) const {
+    ErrorValue operator+(const ErrorValue &ev) && {
+        *this += ev;
+        return std::move(*this);
+    }
+
+    ErrorValue operator+(const T &value_) const & {
         ErrorValue res = *this;
         res += value_;
         return res;
     }
 
-    ErrorValue operator-(const ErrorValue &ev) const {
+    ErrorValue operator+(const T &value_) && {
+        *this += value_;
+        return std::move(*this);
+    }
+
+    ErrorValue operator-(const ErrorValue &ev) const & {
         ErrorValue res = *this;
         res -= ev;
         return res;
     }
 
-    ErrorValue operator-(const T &value_) const {
+    ErrorValue operator-(const ErrorValue &ev) && {
+        *this -= ev;
+        return std::move(*this);
+    }
+
+    ErrorValue operator-(const T &value_) const & {
         ErrorValue res = *this;
         res -= value_;
         return res;
     }
 
-    ErrorValue operator*(const ErrorValue &ev) const {
+    ErrorValue operator-(const T &value_) && {
+        *this -= value_;
+        return std::move(*this);
+    }
+
+    ErrorValue operator*(const ErrorValue &ev) const & {
         ErrorValue res = *this;
         res *= ev;
         return res;
     }
 
-    ErrorValue operator*(const T &value_) const {
+    ErrorValue operator*(const ErrorValue &ev) && {
+        *this *= ev;
+        return std::move(*this);
+    }
+
+    ErrorValue operator*(const T &value_) const & {
         ErrorValue res = *this;
         res *= value_;
         return res;
     }
 
-    ErrorValue operator/(const ErrorValue &ev) const {
+    ErrorValue operator*(const T &value_) && {
+        *this *= value_;
+        return std::move(*this);
+    }
+
+    ErrorValue operator/(const ErrorValue &ev) const & {
         ErrorValue res = *this;
         res /= ev;
         return res;
     }
 
-    ErrorValue operator/(const T &value_) const {
+    ErrorValue operator/(const ErrorValue &ev) && {
+        *this /= ev;
+        return std::move(*this);
+    }
+
+    ErrorValue operator/(const T &value_) const & {
         ErrorValue res = *this;
         res /= value_;
         return res;
     }
 
-    ErrorValue operator+() const {
+    ErrorValue operator/(const T &value_) && {
+        *this /= value_;
+        return std::move(*this);
+    }
+
+    ErrorValue operator+() const & {
         return ErrorValue(*this);
     }
 
+    ErrorValue operator+() && {
+        return std::move(*this);
+    }
+
     ErrorValue operator-() const {
-        return ErrorValue(-value, error);
+        return LIBERRC_TRACE_UNARY(NEG, *this, ErrorValue(-value, error));
     }
 
+    // Counted only, shifting the value leaves the error and its budget as they are
     ErrorValue& operator++() {
+        LIBERRC_COUNT(INC);
         value++;
         return *this;
     }
@@ -195,6 +275,7 @@ public:
     }
 
     ErrorValue& operator--() {
+        LIBERRC_COUNT(DEC);
         value--;
         return *this;
     }
@@ -208,32 +289,36 @@ public:
     //------- COMPARISON OPERATORS -------
 
 #ifdef LIBERRC_CPP2A_SUPPORT
-    std::weak_ordering operator<=>(const ErrorValue  &ev) const {
+    std::partial_ordering operator<=>(const ErrorValue &ev) const {
         return (value <=> ev.value);
     }
+
+    bool operator==(const ErrorValue &ev) const {
+        return value == ev.value;
+    }
 #else
 
-    bool operator<(const ErrorValue &ev) {
+    bool operator<(const ErrorValue &ev) const {
         return value < ev.value;
     }
 
-    bool operator<=(const ErrorValue &ev) {
+    bool operator<=(const ErrorValue &ev) const {
         return value <= ev.value;
     }
 
-    bool operator==(const ErrorValue &ev) {
-        return value = ev.value;
+    bool operator==(const ErrorValue &ev) const {
+        return value == ev.value;
     }
 
-    bool operator>=(const ErrorValue &ev) {
+    bool operator>=(const ErrorValue &ev) const {
         return value >= ev.value;
     }
 
-    bool operator>(const ErrorValue &ev) {
+    bool operator>(const ErrorValue &ev) const {
         return value > ev.value;
     }
 
-    bool operator!=(const ErrorValue &ev) {
+    bool operator!=(const ErrorValue &ev) const {
         return value != ev.value;
     }
 
@@ -269,7 +354,7 @@ public:
     void setDefaultErrorCalculationMethod(int code, std::function<E(T)> fun = nullptr) {
         switch(code) {
             case DEF_ERROR_FUNC:
-                defaultErrorCalcFunction = fun;
+                defaultErrorCalcFunction = fun ? std::make_shared<const std::function<E(T)>>(std::move(fun)) : nullptr;
                 [[fallthrough]];
             case DEF_ERROR_ZERO:
                 [[fallthrough]];
@@ -296,15 +381,16 @@ public:
     }
 
     [[nodiscard]] std::function<E(T)> getDefaultErrorCalcFunction() const {
-        if (numberDefaultErrorCode != DEF_ERROR_FUNC)
+        if (numberDefaultErrorCode != DEF_ERROR_FUNC || !defaultErrorCalcFunction)
             return nullptr;
-        return defaultErrorCalcFunction;
+        return *defaultErrorCalcFunction;
     }
 
 protected:
 
     int numberDefaultErrorCode = DEF_ERROR_ZERO;
-    std::function<E(T)> defaultErrorCalcFunction = nullptr;
+    // Shared and immutable, so copying an ErrorValue in arithmetic never copies (and allocates) the functor
+    std::shared_ptr<const std::function<E(T)>> defaultErrorCalcFunction = nullptr;
 
     E defaultNumberError(T x) {
         switch (numberDefaultErrorCode) {
@@ -313,7 +399,9 @@ protected:
             case DEF_ERROR_HALF:
                 return halfErrorCalcFunction(x);
                 [[unlikely]] case DEF_ERROR_FUNC:
-                return defaultErrorCalcFunction(x);
+                if (!defaultErrorCalcFunction)
+                    throw std::bad_function_call();
+                return (*defaultErrorCalcFunction)(x);
             default:
                 throw std::range_error("Invalid default error function code: " + std::to_string(numberDefaultErrorCode));
         }
@@ -352,118 +440,121 @@ std::ostream& operator<<(std::ostream& os, const ErrorValue<T,E> &ev) {
 #ifndef LIBERRC_NOT_ADD_ERRMATH
     template <typename T, typename E>
     auto sin(const ErrorValue<T, E> &x) {
-        return ErrorValue(sin(x.value), abs(cos(x.value))*x.error);
+        return LIBERRC_TRACE_UNARY(SIN, x, ErrorValue(sin(x.value), std::abs(cos(x.value))*x.error));
     }
 
     template <typename T, typename E>
     auto cos(const ErrorValue<T, E> &x) {
-        return ErrorValue(cos(x.value), abs(sin(x.value)*x.error));
+        return LIBERRC_TRACE_UNARY(COS, x, ErrorValue(cos(x.value), std::abs(sin(x.value)*x.error)));
     }
 
     template <typename T, typename E>
     auto tan(const ErrorValue<T, E> &x) {
-        return ErrorValue(tan(x.value), x.error/pow(cos(x.value), 2));
+        return LIBERRC_TRACE_UNARY(TAN, x, ErrorValue(tan(x.value), x.error/pow(cos(x.value), 2)));
     }
 
     template <typename T, typename E>
     auto asin(const ErrorValue<T, E> &x) {
-        return ErrorValue(asin(x.value), x.error/sqrt(1 - x.value*x.value));
+        return LIBERRC_TRACE_UNARY(ASIN, x, ErrorValue(asin(x.value), x.error/sqrt(1 - x.value*x.value)));
     }
 
     template <typename T, typename E>
     auto acos(const ErrorValue<T, E> &x) {
-        return ErrorValue(acos(x.value), x.error/sqrt(1 - x.value*x.value));
+        return LIBERRC_TRACE_UNARY(ACOS, x, ErrorValue(acos(x.value), x.error/sqrt(1 - x.value*x.value)));
     }
 
     template <typename T, typename E>
     auto atan(const ErrorValue<T, E> &x) {
-        return ErrorValue(atan(x.value), x.error/(1 + x.value*x.value));
+        return LIBERRC_TRACE_UNARY(ATAN, x, ErrorValue(atan(x.value), x.error/(1 + x.value*x.value)));
     }
 
     template <typename T, typename E, typename T1, typename E1>
     auto atan2(const ErrorValue<T, E> &y, const ErrorValue<T1, E1> &x) {
-        return atan(y/x);
+        auto r2 = x.value*x.value + y.value*y.value;
+        auto res = ErrorValue(atan2(y.value, x.value), hypot(x.value*y.error, y.value*x.error)/r2);
+        LIBERRC_TRACE(ATAN2, res, y, x.value*x.value/(r2*r2), x, y.value*y.value/(r2*r2));
+        return res;
     }
 
     template <typename T, typename E>
     auto sinh(const ErrorValue<T, E> &x) {
-        return ErrorValue(sinh(x.value), cosh(x.value)*x.error);
+        return LIBERRC_TRACE_UNARY(SINH, x, ErrorValue(sinh(x.value), cosh(x.value)*x.error));
     }
 
     template <typename T, typename E>
     auto cosh(const ErrorValue<T, E> &x) {
-        return ErrorValue(cosh(x.value), abs(sinh(x.value))*x.error);
+        return LIBERRC_TRACE_UNARY(COSH, x, ErrorValue(cosh(x.value), std::abs(sinh(x.value))*x.error));
     }
 
     template <typename T, typename E>
     auto tanh(const ErrorValue<T, E> &x) {
-        return ErrorValue(tanh(x.value), x.error/pow(cosh(x.value), 2));
+        return LIBERRC_TRACE_UNARY(TANH, x, ErrorValue(tanh(x.value), x.error/pow(cosh(x.value), 2)));
     }
 
     template <typename T, typename E>
     auto asinh(const ErrorValue<T, E> &x) {
-        return ErrorValue(asinh(x.value), x.error/sqrt(1 + x.value*x.value));
+        return LIBERRC_TRACE_UNARY(ASINH, x, ErrorValue(asinh(x.value), x.error/sqrt(1 + x.value*x.value)));
     }
 
     template <typename T, typename E>
     auto acosh(const ErrorValue<T, E> &x) {
-        return ErrorValue(acosh(x.value), x.error/sqrt(x.value*x.value - 1));
+        return LIBERRC_TRACE_UNARY(ACOSH, x, ErrorValue(acosh(x.value), x.error/sqrt(x.value*x.value - 1)));
     }
 
     template <typename T, typename E>
     auto atanh(const ErrorValue<T, E> &x) {
-        return ErrorValue(atanh(x.value), x.error/(1 - x.value*x.value));
+        return LIBERRC_TRACE_UNARY(ATANH, x, ErrorValue(atanh(x.value), x.error/(1 - x.value*x.value)));
     }
 
     template <typename T, typename E>
     auto erf(const ErrorValue<T, E> &x) {
-        return ErrorValue(
+        return LIBERRC_TRACE_UNARY(ERF, x, ErrorValue(
                 erf(x.value),
                 2*exp(-x.value*x.value)*x.error/sqrt(M_PI)
-        );
+        ));
     }
 
     template <typename T, typename E>
     auto erfc(const ErrorValue<T, E> &x) {
-        return ErrorValue(
+        return LIBERRC_TRACE_UNARY(ERFC, x, ErrorValue(
                 erfc(x.value),
                 2*exp(-x.value*x.value)*x.error/sqrt(M_PI)
-        );
+        ));
     }
 
     template <typename T, typename E>
     auto exp(const ErrorValue<T, E> &x) {
-        return ErrorValue(exp(x.value), exp(x.value)*x.error);
+        return LIBERRC_TRACE_UNARY(EXP, x, ErrorValue(exp(x.value), exp(x.value)*x.error));
     }
 
     template <typename T, typename E>
     auto log10(const ErrorValue<T, E> &x) {
-        return ErrorValue(log10(x.value), x.error/(x.value * log(static_cast<E>(10))));
+        return LIBERRC_TRACE_UNARY(LOG10, x, ErrorValue(log10(x.value), x.error/(x.value * log(static_cast<E>(10)))));
     }
 
     template <typename T, typename E>
     auto exp2(const ErrorValue<T, E> &x) {
-        return ErrorValue(exp2(x.value), exp2(x.value)*log(static_cast<E>(2))*x.error);
+        return LIBERRC_TRACE_UNARY(EXP2, x, ErrorValue(exp2(x.value), exp2(x.value)*log(static_cast<E>(2))*x.error));
     }
 
     template <typename T, typename E>
     auto log2(const ErrorValue<T, E> &x) {
-        return ErrorValue(log2(x.value), x.error/(x.value*log(static_cast<E>(2))));
+        return LIBERRC_TRACE_UNARY(LOG2, x, ErrorValue(log2(x.value), x.error/(x.value*log(static_cast<E>(2)))));
     }
 
     template <typename T, typename E>
     auto log(const ErrorValue<T, E> &x) {
-        return ErrorValue(log(x.value), x.error/x.value);
+        return LIBERRC_TRACE_UNARY(LOG, x, ErrorValue(log(x.value), x.error/x.value));
     }
 
     template <typename T, typename E>
     auto expm1(const ErrorValue<T, E> &x) {
-        return ErrorValue(expm1(x.value), exp(x.value)*x.error);
+        return LIBERRC_TRACE_UNARY(EXPM1, x, ErrorValue(expm1(x.value), exp(x.value)*x.error));
     }
 
     template <typename T, typename E>
     auto log1p(const ErrorValue<T, E> &x) {
-        return ErrorValue(log1p(x.value), x.error/(1 + x.value));
+        return LIBERRC_TRACE_UNARY(LOG1P, x, ErrorValue(log1p(x.value), x.error/(1 + x.value)));
     }
 
 #ifdef LIBERRC_CPP2A_SUPPORT
@@ -476,10 +567,10 @@ std::ostream& operator<<(std::ostream& os, const ErrorValue<T,E> &ev) {
         static_assert(std::is_arithmetic<N>::value,
                       "Type of logn base value must be integral");
 #endif
-        return ErrorValue<T, E>(
+        return LIBERRC_TRACE_UNARY(LOGN, x, ErrorValue<T, E>(
                 log(x.value)/log(n),
                 x.error/(x.value*log(n))
-                );
+                ));
     }
 #ifdef LIBERRC_CPP2A_SUPPORT
     template <std::integral T, std::floating_point E, Arithmetic N>
@@ -491,20 +582,22 @@ std::ostream& operator<<(std::ostream& os, const ErrorValue<T,E> &ev) {
         static_assert(std::is_integral<N>::value,
                       "Type of logn base value must be integral");
 #endif
-        return ErrorValue<double , E>(
+        return LIBERRC_TRACE_UNARY(LOGN, x, ErrorValue<double , E>(
                 log(x.value)/log(n),
                 x.error/(x.value*log(n))
-        );
+        ));
     }
 
     template <typename T, typename E, typename T1, typename E1>
     auto pow(const ErrorValue<T , E>& base, const ErrorValue<T1, E1>& exponent) {
         T x = base.value, y = exponent.value;
         T dx = base.error, dy = exponent.error;
-        return ErrorValue(
+        auto res = ErrorValue(
                 pow(x, y),
                 sqrt(pow(y*pow(x, y - 1)*dx, 2) + pow(pow(x, y)*log(x)*dy, 2))
                 );
+        LIBERRC_TRACE(POW, res, base, pow(y*pow(x, y - 1), 2), exponent, pow(pow(x, y)*log(x), 2));
+        return res;
     }
 
 #ifdef LIBERRC_CPP2A_SUPPORT
@@ -516,35 +609,37 @@ template <typename T, typename E, Arithmetic N>
         static_assert(std::is_arithmetic<N>::value && !std::is_same<N, bool>::value,
                       "Type of exponent base value must be arithmetic, but not bool");
 #endif
-        return ErrorValue(
+        return LIBERRC_TRACE_UNARY(POW, base, ErrorValue(
                 pow(base.value, exponent),
-                abs(exponent*pow(base.value, exponent - 1))*base.error
-        );
+                std::abs(exponent*pow(base.value, exponent - 1))*base.error
+        ));
     }
 
     template <typename T, typename E>
     auto sqrt(const ErrorValue<T, E> &x) {
-        return ErrorValue(sqrt(x.value), x.error/(2*sqrt(x.value)));
+        return LIBERRC_TRACE_UNARY(SQRT, x, ErrorValue(sqrt(x.value), x.error/(2*sqrt(x.value))));
     }
 
     template <typename T, typename E>
     auto cbrt(const ErrorValue<T, E> &x) {
-        return ErrorValue(cbrt(x.value), x.error/(3*pow(x.value, 2.0/3)));
+        return LIBERRC_TRACE_UNARY(CBRT, x, ErrorValue(cbrt(x.value), x.error/(3*pow(x.value, 2.0/3))));
     }
 
     template <typename T, typename E, typename T1, typename E1>
     auto hypot(const ErrorValue<T , E>& x_, const ErrorValue<T1, E1>& y_) {
         T x = x_.value, y = y_.value;
         T dx = x_.error, dy = y_.error;
-        return ErrorValue(
+        auto res = ErrorValue(
                 hypot(x, y),
                 sqrt(pow(x*dx, 2) + pow(y*dy, 2))/sqrt(x*x + y*y)
                 );
+        LIBERRC_TRACE(HYPOT, res, x_, x*x/(x*x + y*y), y_, y*y/(x*x + y*y));
+        return res;
     }
 
     template <typename T, typename E>
     auto abs(const ErrorValue<T, E> &x) {
-        return ErrorValue(abs(x.value), x.error);
+        return LIBERRC_TRACE_UNARY(ABS, x, ErrorValue(std::abs(x.value), x.error));
     }
 
     template <typename T, typename E, typename T1, typename E1, typename T2, typename E2>
@@ -553,9 +648,15 @@ template <typename T, typename E, Arithmetic N>
         E dx = x_.error, dy = y_.error, dz = z_.error;
         E ex = dx/x;
         E ey = dy/y;
-        return ErrorValue(fma(x, y, z), sqrt(x*x*y*y*(ex*ex + ey*ey) + dz*dz));
+        auto res = ErrorValue(fma(x, y, z), sqrt(x*x*y*y*(ex*ex + ey*ey) + dz*dz));
+        LIBERRC_TRACE(FMA, res, x_, y*y, y_, x*x, z_, 1);
+        return res;
     }
 
 #endif //LIBERRC_ADD_ERRMATH
 
+#ifdef LIBERRC_EXTERN_TEMPLATES
+#include "errc_extern.h"
+#endif
+
 #endif //LIBERRC_ERRC_H
@@ -0,0 +1,298 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_BATCH_H
+#define LIBERRC_ERRC_BATCH_H
+
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "errc.h"
+#include "errc_simd.h"
+
+namespace liberrc {
+
+    // Structure of arrays of ErrorValue<T, T>: values and errors are stored in two separate arrays, so batch
+    // kernels can load whole SIMD registers of either.
+    template <typename T>
+    class ErrorArray {
+
+        static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+                      "Type of ErrorArray elements must be float or double");
+
+    public:
+
+        std::vector<T> value;
+        std::vector<T> error;
+
+        //------- CONSTRUCTORS -------
+
+        ErrorArray() = default;
+        explicit ErrorArray(std::size_t size) : value(size), error(size) {};
+
+        ErrorArray(std::initializer_list<ErrorValue<T, T>> list) {
+            reserve(list.size());
+            for (const ErrorValue<T, T> &ev : list)
+                push_back(ev);
+        }
+
+        //------- MEMBER OPERATORS -------
+
+        ErrorValue<T, T> operator[](std::size_t i) const {
+            return ErrorValue<T, T>(value[i], error[i]);
+        }
+
+        //------- VOID METHODS -------
+
+        void set(std::size_t i, T value_, T error_) {
+            value[i] = value_;
+            error[i] = error_;
+        }
+
+        void push_back(const ErrorValue<T, T> &ev) {
+            value.push_back(ev.value);
+            error.push_back(ev.error);
+        }
+
+        void resize(std::size_t size) {
+            value.resize(size);
+            error.resize(size);
+        }
+
+        void reserve(std::size_t size) {
+            value.reserve(size);
+            error.reserve(size);
+        }
+
+        //------- NON-VOID METHODS -------
+
+        [[nodiscard]] std::size_t size() const {
+            return value.size();
+        }
+
+        [[nodiscard]] bool empty() const {
+            return value.empty();
+        }
+
+    };
+
+    namespace batch {
+
+        template <typename T>
+        using BinaryKernel = void (*)(const T*, const T*, const T*, const T*, T*, T*, std::size_t);
+
+        template <typename T>
+        using UnaryKernel = void (*)(const T*, const T*, T*, T*, std::size_t);
+
+        template <typename T>
+        using ReductionKernel = ErrorValue<T, T> (*)(const T*, const T*, std::size_t);
+
+        template <typename T>
+        struct Kernels {
+            simd::Isa isa;
+            BinaryKernel<T> add;
+            BinaryKernel<T> sub;
+            BinaryKernel<T> mul;
+            BinaryKernel<T> div;
+            UnaryKernel<T> sqrt;
+            UnaryKernel<T> exp;
+            UnaryKernel<T> log;
+            UnaryKernel<T> sin;
+            UnaryKernel<T> cos;
+            ReductionKernel<T> sum;
+            ReductionKernel<T> weightedMean;
+        };
+
+    }
+
+}
+
+#define LIBERRC_KERNELS_FILE "errc_batch_kernels.inl"
+#include "errc_foreach_isa.h"
+
+namespace liberrc {
+
+    namespace batch {
+
+        //------- DISPATCH -------
+
+        template <typename T>
+        const Kernels<T>& kernels(simd::Isa isa) {
+            return simd::onIsa(isa, [](auto target) -> const Kernels<T>& {
+                return batchKernels(target, static_cast<T*>(nullptr));
+            });
+        }
+
+        // Bound once, on first use, to the best ISA of this CPU (see simd::activeIsa)
+        template <typename T>
+        const Kernels<T>& kernels() {
+            static const Kernels<T> &bound = kernels<T>(simd::activeIsa());
+            return bound;
+        }
+
+        //------- RAW ARRAY FUNCTIONS -------
+
+        template <typename T>
+        void add(const T* av, const T* ae, const T* bv, const T* be, T* rv, T* re, std::size_t n) {
+            kernels<T>().add(av, ae, bv, be, rv, re, n);
+        }
+
+        template <typename T>
+        void sub(const T* av, const T* ae, const T* bv, const T* be, T* rv, T* re, std::size_t n) {
+            kernels<T>().sub(av, ae, bv, be, rv, re, n);
+        }
+
+        template <typename T>
+        void mul(const T* av, const T* ae, const T* bv, const T* be, T* rv, T* re, std::size_t n) {
+            kernels<T>().mul(av, ae, bv, be, rv, re, n);
+        }
+
+        template <typename T>
+        void div(const T* av, const T* ae, const T* bv, const T* be, T* rv, T* re, std::size_t n) {
+            kernels<T>().div(av, ae, bv, be, rv, re, n);
+        }
+
+        template <typename T>
+        void sqrt(const T* xv, const T* xe, T* rv, T* re, std::size_t n) {
+            kernels<T>().sqrt(xv, xe, rv, re, n);
+        }
+
+        template <typename T>
+        void exp(const T* xv, const T* xe, T* rv, T* re, std::size_t n) {
+            kernels<T>().exp(xv, xe, rv, re, n);
+        }
+
+        template <typename T>
+        void log(const T* xv, const T* xe, T* rv, T* re, std::size_t n) {
+            kernels<T>().log(xv, xe, rv, re, n);
+        }
+
+        template <typename T>
+        void sin(const T* xv, const T* xe, T* rv, T* re, std::size_t n) {
+            kernels<T>().sin(xv, xe, rv, re, n);
+        }
+
+        template <typename T>
+        void cos(const T* xv, const T* xe, T* rv, T* re, std::size_t n) {
+            kernels<T>().cos(xv, xe, rv, re, n);
+        }
+
+        template <typename T>
+        ErrorValue<T, T> sum(const T* xv, const T* xe, std::size_t n) {
+            return kernels<T>().sum(xv, xe, n);
+        }
+
+        template <typename T>
+        ErrorValue<T, T> weightedMean(const T* xv, const T* xe, std::size_t n) {
+            return kernels<T>().weightedMean(xv, xe, n);
+        }
+
+        //------- ERRORARRAY HELPERS -------
+
+        template <typename T>
+        void checkSizes(const ErrorArray<T> &a, const ErrorArray<T> &b) {
+            if (a.size() != b.size())
+                throw std::invalid_argument("ErrorArray sizes must match: " + std::to_string(a.size()) +
+                                            " and " + std::to_string(b.size()));
+        }
+
+        template <typename T>
+        ErrorArray<T> apply(BinaryKernel<T> kernel, const ErrorArray<T> &a, const ErrorArray<T> &b) {
+            checkSizes(a, b);
+            ErrorArray<T> res(a.size());
+            kernel(a.value.data(), a.error.data(), b.value.data(), b.error.data(),
+                   res.value.data(), res.error.data(), a.size());
+            return res;
+        }
+
+        template <typename T>
+        ErrorArray<T> apply(UnaryKernel<T> kernel, const ErrorArray<T> &x) {
+            ErrorArray<T> res(x.size());
+            kernel(x.value.data(), x.error.data(), res.value.data(), res.error.data(), x.size());
+            return res;
+        }
+
+    }
+
+    //------- ERRORARRAY ARITHMETIC OPERATORS -------
+
+    template <typename T>
+    ErrorArray<T> operator+(const ErrorArray<T> &a, const ErrorArray<T> &b) {
+        return batch::apply(batch::kernels<T>().add, a, b);
+    }
+
+    template <typename T>
+    ErrorArray<T> operator-(const ErrorArray<T> &a, const ErrorArray<T> &b) {
+        return batch::apply(batch::kernels<T>().sub, a, b);
+    }
+
+    template <typename T>
+    ErrorArray<T> operator*(const ErrorArray<T> &a, const ErrorArray<T> &b) {
+        return batch::apply(batch::kernels<T>().mul, a, b);
+    }
+
+    template <typename T>
+    ErrorArray<T> operator/(const ErrorArray<T> &a, const ErrorArray<T> &b) {
+        return batch::apply(batch::kernels<T>().div, a, b);
+    }
+
+    //------- ERRORARRAY ERRMATH -------
+
+    template <typename T>
+    ErrorArray<T> sqrt(const ErrorArray<T> &x) {
+        return batch::apply(batch::kernels<T>().sqrt, x);
+    }
+
+    template <typename T>
+    ErrorArray<T> exp(const ErrorArray<T> &x) {
+        return batch::apply(batch::kernels<T>().exp, x);
+    }
+
+    template <typename T>
+    ErrorArray<T> log(const ErrorArray<T> &x) {
+        return batch::apply(batch::kernels<T>().log, x);
+    }
+
+    template <typename T>
+    ErrorArray<T> sin(const ErrorArray<T> &x) {
+        return batch::apply(batch::kernels<T>().sin, x);
+    }
+
+    template <typename T>
+    ErrorArray<T> cos(const ErrorArray<T> &x) {
+        return batch::apply(batch::kernels<T>().cos, x);
+    }
+
+    //------- ERRORARRAY REDUCTIONS -------
+
+    template <typename T>
+    ErrorValue<T, T> sum(const ErrorArray<T> &x) {
+        return batch::kernels<T>().sum(x.value.data(), x.error.data(), x.size());
+    }
+
+    template <typename T>
+    ErrorValue<T, T> weightedMean(const ErrorArray<T> &x) {
+        return batch::kernels<T>().weightedMean(x.value.data(), x.error.data(), x.size());
+    }
+
+}
+
+#endif //LIBERRC_ERRC_BATCH_H
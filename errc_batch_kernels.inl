@@ -0,0 +1,201 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+// Batch kernels over SoA value/error arrays. Included by errc_foreach_isa.h into every liberrc::simd::<isa>
+// namespace, Pack<T> below is the pack type of that ISA. Every block loads its inputs before storing, so output
+// arrays may alias input arrays.
+
+//------- HELPERS -------
+
+template <typename T, typename Block>
+inline void forEachBlock(std::size_t n, Block block) {
+    std::size_t i = 0;
+    for (; i + Pack<T>::width <= n; i += Pack<T>::width)
+        block(Pack<T>(), i);
+    for (; i < n; ++i)
+        block(scalar::Pack<T>(), i);
+}
+
+// Evaluates a scalar <cmath> function lane by lane, the propagation around it stays vectorized.
+template <typename P, typename T, typename F>
+inline P mapLanes(const T* x, F f) {
+    T lanes[P::width];
+    for (std::size_t k = 0; k < P::width; ++k)
+        lanes[k] = f(x[k]);
+    return P::load(lanes);
+}
+
+//------- ARITHMETIC KERNELS -------
+
+template <typename T>
+void addKernel(const T* av, const T* ae, const T* bv, const T* be, T* rv, T* re, std::size_t n) {
+    forEachBlock<T>(n, [=](auto p, std::size_t i) {
+        using P = decltype(p);
+        P ea = P::load(ae + i), eb = P::load(be + i);
+        P v = P::load(av + i) + P::load(bv + i);
+        v.store(rv + i);
+        sqrt(fma(ea, ea, eb*eb)).store(re + i);
+    });
+}
+
+template <typename T>
+void subKernel(const T* av, const T* ae, const T* bv, const T* be, T* rv, T* re, std::size_t n) {
+    forEachBlock<T>(n, [=](auto p, std::size_t i) {
+        using P = decltype(p);
+        P ea = P::load(ae + i), eb = P::load(be + i);
+        P v = P::load(av + i) - P::load(bv + i);
+        v.store(rv + i);
+        sqrt(fma(ea, ea, eb*eb)).store(re + i);
+    });
+}
+
+template <typename T>
+void mulKernel(const T* av, const T* ae, const T* bv, const T* be, T* rv, T* re, std::size_t n) {
+    forEachBlock<T>(n, [=](auto p, std::size_t i) {
+        using P = decltype(p);
+        P a = P::load(av + i), b = P::load(bv + i);
+        P da = b*P::load(ae + i), db = a*P::load(be + i);
+        (a*b).store(rv + i);
+        sqrt(fma(da, da, db*db)).store(re + i);
+    });
+}
+
+template <typename T>
+void divKernel(const T* av, const T* ae, const T* bv, const T* be, T* rv, T* re, std::size_t n) {
+    forEachBlock<T>(n, [=](auto p, std::size_t i) {
+        using P = decltype(p);
+        P b = P::load(bv + i), ea = P::load(ae + i);
+        P v = P::load(av + i)/b;
+        P dv = v*P::load(be + i);
+        v.store(rv + i);
+        (sqrt(fma(ea, ea, dv*dv))/abs(b)).store(re + i);
+    });
+}
+
+//------- ERRMATH KERNELS -------
+
+template <typename T>
+void sqrtKernel(const T* xv, const T* xe, T* rv, T* re, std::size_t n) {
+    forEachBlock<T>(n, [=](auto p, std::size_t i) {
+        using P = decltype(p);
+        P v = sqrt(P::load(xv + i));
+        P e = P::load(xe + i);
+        v.store(rv + i);
+        (e/(v + v)).store(re + i);
+    });
+}
+
+template <typename T>
+void expKernel(const T* xv, const T* xe, T* rv, T* re, std::size_t n) {
+    forEachBlock<T>(n, [=](auto p, std::size_t i) {
+        using P = decltype(p);
+        P v = mapLanes<P>(xv + i, [](T y) { return std::exp(y); });
+        P e = P::load(xe + i);
+        v.store(rv + i);
+        (v*e).store(re + i);
+    });
+}
+
+template <typename T>
+void logKernel(const T* xv, const T* xe, T* rv, T* re, std::size_t n) {
+    forEachBlock<T>(n, [=](auto p, std::size_t i) {
+        using P = decltype(p);
+        P x = P::load(xv + i), e = P::load(xe + i);
+        P v = mapLanes<P>(xv + i, [](T y) { return std::log(y); });
+        v.store(rv + i);
+        (e/abs(x)).store(re + i);
+    });
+}
+
+template <typename T>
+void sinKernel(const T* xv, const T* xe, T* rv, T* re, std::size_t n) {
+    forEachBlock<T>(n, [=](auto p, std::size_t i) {
+        using P = decltype(p);
+        P v = mapLanes<P>(xv + i, [](T y) { return std::sin(y); });
+        P d = mapLanes<P>(xv + i, [](T y) { return std::cos(y); });
+        P e = P::load(xe + i);
+        v.store(rv + i);
+        (abs(d)*e).store(re + i);
+    });
+}
+
+template <typename T>
+void cosKernel(const T* xv, const T* xe, T* rv, T* re, std::size_t n) {
+    forEachBlock<T>(n, [=](auto p, std::size_t i) {
+        using P = decltype(p);
+        P v = mapLanes<P>(xv + i, [](T y) { return std::cos(y); });
+        P d = mapLanes<P>(xv + i, [](T y) { return std::sin(y); });
+        P e = P::load(xe + i);
+        v.store(rv + i);
+        (abs(d)*e).store(re + i);
+    });
+}
+
+//------- REDUCTION KERNELS -------
+
+template <typename T>
+ErrorValue<T, T> sumKernel(const T* xv, const T* xe, std::size_t n) {
+    using P = Pack<T>;
+    P sv = P::zero(), se = P::zero();
+    std::size_t i = 0;
+    for (; i + P::width <= n; i += P::width) {
+        P e = P::load(xe + i);
+        sv = sv + P::load(xv + i);
+        se = fma(e, e, se);
+    }
+    T value = hsum(sv), variance = hsum(se);
+    for (; i < n; ++i) {
+        value += xv[i];
+        variance += xe[i]*xe[i];
+    }
+    return ErrorValue<T, T>(value, std::sqrt(variance));
+}
+
+// Inverse-variance weighted mean, elements with zero error get infinite weight.
+template <typename T>
+ErrorValue<T, T> weightedMeanKernel(const T* xv, const T* xe, std::size_t n) {
+    using P = Pack<T>;
+    P swx = P::zero(), sw = P::zero(), one = P::broadcast(1);
+    std::size_t i = 0;
+    for (; i + P::width <= n; i += P::width) {
+        P e = P::load(xe + i);
+        P w = one/(e*e);
+        swx = fma(w, P::load(xv + i), swx);
+        sw = sw + w;
+    }
+    T weightedSum = hsum(swx), weights = hsum(sw);
+    for (; i < n; ++i) {
+        T w = 1/(xe[i]*xe[i]);
+        weightedSum += w*xv[i];
+        weights += w;
+    }
+    return ErrorValue<T, T>(weightedSum/weights, 1/std::sqrt(weights));
+}
+
+//------- KERNEL TABLE -------
+
+template <typename T>
+const batch::Kernels<T>& batchKernels(Target, T*) {
+    static constexpr batch::Kernels<T> table = {
+            TARGET_ISA,
+            &addKernel<T>, &subKernel<T>, &mulKernel<T>, &divKernel<T>,
+            &sqrtKernel<T>, &expKernel<T>, &logKernel<T>, &sinKernel<T>, &cosKernel<T>,
+            &sumKernel<T>, &weightedMeanKernel<T>
+    };
+    return table;
+}
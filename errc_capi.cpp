@@ -0,0 +1,167 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include "errc_capi.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "errc_batch.h"
+
+namespace {
+
+    using namespace liberrc;
+
+    template <typename... P>
+    bool valid(std::size_t n, const P*... p) {
+        return n == 0 || ((p != nullptr) && ...);
+    }
+
+    template <typename T>
+    int binary(batch::BinaryKernel<T> kernel, const T* av, const T* ae, const T* bv, const T* be, T* rv, T* re,
+               std::size_t n) {
+        if (!valid(n, av, ae, bv, be, rv, re))
+            return LIBERRC_ERROR_NULL_POINTER;
+        kernel(av, ae, bv, be, rv, re, n);
+        return LIBERRC_OK;
+    }
+
+    template <typename T>
+    int unary(batch::UnaryKernel<T> kernel, const T* xv, const T* xe, T* rv, T* re, std::size_t n) {
+        if (!valid(n, xv, xe, rv, re))
+            return LIBERRC_ERROR_NULL_POINTER;
+        kernel(xv, xe, rv, re, n);
+        return LIBERRC_OK;
+    }
+
+    template <typename T>
+    int reduction(batch::ReductionKernel<T> kernel, const T* xv, const T* xe, std::size_t n, T* rv, T* re) {
+        if (!valid(n, xv, xe) || rv == nullptr || re == nullptr)
+            return LIBERRC_ERROR_NULL_POINTER;
+        ErrorValue<T, T> r = kernel(xv, xe, n);
+        *rv = r.value;
+        *re = r.error;
+        return LIBERRC_OK;
+    }
+
+    template <typename T>
+    int format(const T* xv, const T* xe, std::size_t n, int precision, char* out, std::size_t capacity,
+               std::size_t* length) {
+        if (!valid(n, xv, xe) || (out == nullptr && capacity != 0) || length == nullptr)
+            return LIBERRC_ERROR_NULL_POINTER;
+        if (precision < 0)
+            precision = 5;
+        // A precision near INT_MAX makes snprintf fail with EOVERFLOW
+        precision = std::min(precision, LIBERRC_MAX_PRECISION);
+        if (capacity != 0)
+            out[0] = '\0';
+        std::size_t pos = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            // snprintf truncates at the end of out and returns the full length, so pos keeps counting
+            const std::size_t left = pos < capacity ? capacity - pos : 0;
+            int written = std::snprintf(left != 0 ? out + pos : nullptr, left, "%s%.*f \xc2\xb1 %.*f",
+                                        i == 0 ? "" : "\n", precision, static_cast<double>(xv[i]),
+                                        precision, static_cast<double>(xe[i]));
+            if (written < 0) {
+                *length = 0;
+                return LIBERRC_ERROR_FORMAT;
+            }
+            pos += static_cast<std::size_t>(written);
+        }
+        *length = pos;
+        // Capacity 0 only asks for the length, like snprintf(NULL, 0, ...)
+        return capacity == 0 || pos < capacity ? LIBERRC_OK : LIBERRC_ERROR_BUFFER_TOO_SMALL;
+    }
+
+}
+
+//------- VERSION -------
+
+int liberrc_abi_version(void) {
+    return LIBERRC_ABI_VERSION;
+}
+
+const char* liberrc_isa_name(void) {
+    return simd::isaName(batch::kernels<double>().isa);
+}
+
+//------- ARITHMETIC -------
+
+#define LIBERRC_CAPI_BINARY(name, T, suffix) \
+    int liberrc_##name##_##suffix(const T* av, const T* ae, const T* bv, const T* be, T* rv, T* re, size_t n) { \
+        return binary(batch::kernels<T>().name, av, ae, bv, be, rv, re, n); \
+    }
+
+LIBERRC_CAPI_BINARY(add, double, f64)
+LIBERRC_CAPI_BINARY(sub, double, f64)
+LIBERRC_CAPI_BINARY(mul, double, f64)
+LIBERRC_CAPI_BINARY(div, double, f64)
+
+LIBERRC_CAPI_BINARY(add, float, f32)
+LIBERRC_CAPI_BINARY(sub, float, f32)
+LIBERRC_CAPI_BINARY(mul, float, f32)
+LIBERRC_CAPI_BINARY(div, float, f32)
+
+//------- ERRMATH -------
+
+#define LIBERRC_CAPI_UNARY(name, T, suffix) \
+    int liberrc_##name##_##suffix(const T* xv, const T* xe, T* rv, T* re, size_t n) { \
+        return unary(batch::kernels<T>().name, xv, xe, rv, re, n); \
+    }
+
+LIBERRC_CAPI_UNARY(sqrt, double, f64)
+LIBERRC_CAPI_UNARY(exp, double, f64)
+LIBERRC_CAPI_UNARY(log, double, f64)
+LIBERRC_CAPI_UNARY(sin, double, f64)
+LIBERRC_CAPI_UNARY(cos, double, f64)
+
+LIBERRC_CAPI_UNARY(sqrt, float, f32)
+LIBERRC_CAPI_UNARY(exp, float, f32)
+LIBERRC_CAPI_UNARY(log, float, f32)
+LIBERRC_CAPI_UNARY(sin, float, f32)
+LIBERRC_CAPI_UNARY(cos, float, f32)
+
+//------- REDUCTIONS -------
+
+int liberrc_sum_f64(const double* xv, const double* xe, size_t n, double* rv, double* re) {
+    return reduction(batch::kernels<double>().sum, xv, xe, n, rv, re);
+}
+
+int liberrc_weighted_mean_f64(const double* xv, const double* xe, size_t n, double* rv, double* re) {
+    return reduction(batch::kernels<double>().weightedMean, xv, xe, n, rv, re);
+}
+
+int liberrc_sum_f32(const float* xv, const float* xe, size_t n, float* rv, float* re) {
+    return reduction(batch::kernels<float>().sum, xv, xe, n, rv, re);
+}
+
+int liberrc_weighted_mean_f32(const float* xv, const float* xe, size_t n, float* rv, float* re) {
+    return reduction(batch::kernels<float>().weightedMean, xv, xe, n, rv, re);
+}
+
+//------- FORMATTING -------
+
+int liberrc_format_f64(const double* xv, const double* xe, size_t n, int precision, char* out, size_t capacity,
+                       size_t* length) {
+    return format(xv, xe, n, precision, out, capacity, length);
+}
+
+int liberrc_format_f32(const float* xv, const float* xe, size_t n, int precision, char* out, size_t capacity,
+                       size_t* length) {
+    return format(xv, xe, n, precision, out, capacity, length);
+}
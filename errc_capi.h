@@ -0,0 +1,126 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_CAPI_H
+#define LIBERRC_ERRC_CAPI_H
+
+/*
+ * C interface of the compiled liberrc library, for callers that cannot use the C++ templates (Python, Rust,
+ * Julia, ...). Every function works on whole arrays given as separate value and error buffers of n elements, so a
+ * foreign caller crosses the boundary once per array. Output buffers may alias input buffers. Functions return
+ * LIBERRC_OK or a negative status, they never throw and never allocate.
+ *
+ * The ABI only grows: functions are never removed or changed, LIBERRC_ABI_VERSION increases when new ones are
+ * added. Compare it with liberrc_abi_version() at run time.
+ */
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#if defined(LIBERRC_BUILDING_LIBRARY)
+#define LIBERRC_API __declspec(dllexport)
+#else
+#define LIBERRC_API __declspec(dllimport)
+#endif
+#else
+#define LIBERRC_API __attribute__((visibility("default")))
+#endif
+
+#define LIBERRC_ABI_VERSION 1
+
+#define LIBERRC_OK 0
+#define LIBERRC_ERROR_NULL_POINTER (-1)
+#define LIBERRC_ERROR_BUFFER_TOO_SMALL (-2)
+/* snprintf failed, the text of an element would not fit in an int */
+#define LIBERRC_ERROR_FORMAT (-3)
+
+/* Largest precision of liberrc_format_*, digits past the 17 of a double only spell out its binary expansion */
+#define LIBERRC_MAX_PRECISION 64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+LIBERRC_API int liberrc_abi_version(void);
+
+/* Name of the instruction set the kernels were bound to: "scalar", "sse2", "avx2" or "avx512" */
+LIBERRC_API const char* liberrc_isa_name(void);
+
+/*------- ARITHMETIC -------*/
+
+/* r[i] = a[i] op b[i] with first-order error propagation */
+LIBERRC_API int liberrc_add_f64(const double* av, const double* ae, const double* bv, const double* be,
+                                double* rv, double* re, size_t n);
+LIBERRC_API int liberrc_sub_f64(const double* av, const double* ae, const double* bv, const double* be,
+                                double* rv, double* re, size_t n);
+LIBERRC_API int liberrc_mul_f64(const double* av, const double* ae, const double* bv, const double* be,
+                                double* rv, double* re, size_t n);
+LIBERRC_API int liberrc_div_f64(const double* av, const double* ae, const double* bv, const double* be,
+                                double* rv, double* re, size_t n);
+
+LIBERRC_API int liberrc_add_f32(const float* av, const float* ae, const float* bv, const float* be,
+                                float* rv, float* re, size_t n);
+LIBERRC_API int liberrc_sub_f32(const float* av, const float* ae, const float* bv, const float* be,
+                                float* rv, float* re, size_t n);
+LIBERRC_API int liberrc_mul_f32(const float* av, const float* ae, const float* bv, const float* be,
+                                float* rv, float* re, size_t n);
+LIBERRC_API int liberrc_div_f32(const float* av, const float* ae, const float* bv, const float* be,
+                                float* rv, float* re, size_t n);
+
+/*------- ERRMATH -------*/
+
+LIBERRC_API int liberrc_sqrt_f64(const double* xv, const double* xe, double* rv, double* re, size_t n);
+LIBERRC_API int liberrc_exp_f64(const double* xv, const double* xe, double* rv, double* re, size_t n);
+LIBERRC_API int liberrc_log_f64(const double* xv, const double* xe, double* rv, double* re, size_t n);
+LIBERRC_API int liberrc_sin_f64(const double* xv, const double* xe, double* rv, double* re, size_t n);
+LIBERRC_API int liberrc_cos_f64(const double* xv, const double* xe, double* rv, double* re, size_t n);
+
+LIBERRC_API int liberrc_sqrt_f32(const float* xv, const float* xe, float* rv, float* re, size_t n);
+LIBERRC_API int liberrc_exp_f32(const float* xv, const float* xe, float* rv, float* re, size_t n);
+LIBERRC_API int liberrc_log_f32(const float* xv, const float* xe, float* rv, float* re, size_t n);
+LIBERRC_API int liberrc_sin_f32(const float* xv, const float* xe, float* rv, float* re, size_t n);
+LIBERRC_API int liberrc_cos_f32(const float* xv, const float* xe, float* rv, float* re, size_t n);
+
+/*------- REDUCTIONS -------*/
+
+/* Writes the result to *rv, *re */
+LIBERRC_API int liberrc_sum_f64(const double* xv, const double* xe, size_t n, double* rv, double* re);
+LIBERRC_API int liberrc_weighted_mean_f64(const double* xv, const double* xe, size_t n, double* rv, double* re);
+
+LIBERRC_API int liberrc_sum_f32(const float* xv, const float* xe, size_t n, float* rv, float* re);
+LIBERRC_API int liberrc_weighted_mean_f32(const float* xv, const float* xe, size_t n, float* rv, float* re);
+
+/*------- FORMATTING -------*/
+
+/*
+ * Writes "value ± error" for every element, one per line, with precision digits after the decimal point (a
+ * negative precision uses 5, like operator<<, and one above LIBERRC_MAX_PRECISION uses the maximum). *length
+ * receives the length of the full text without the terminating NUL. If capacity is too small, out holds as much as
+ * fits, NUL-terminated, and LIBERRC_ERROR_BUFFER_TOO_SMALL is returned. Capacity 0 (out may then be NULL) only
+ * queries the length and returns LIBERRC_OK, like snprintf. LIBERRC_ERROR_FORMAT means snprintf failed.
+ */
+LIBERRC_API int liberrc_format_f64(const double* xv, const double* xe, size_t n, int precision, char* out,
+                                   size_t capacity, size_t* length);
+LIBERRC_API int liberrc_format_f32(const float* xv, const float* xe, size_t n, int precision, char* out,
+                                   size_t capacity, size_t* length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBERRC_ERRC_CAPI_H */
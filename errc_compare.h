@@ -0,0 +1,361 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_COMPARE_H
+#define LIBERRC_ERRC_COMPARE_H
+
+// Uncertainty-aware comparisons. Two measurements are consistent within k sigma if |a - b| <= k*sqrt(ea^2 + eb^2),
+// a is significantly greater than b if a - b > k*sqrt(ea^2 + eb^2). Comparisons involving NaN are false.
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "errc.h"
+#include "errc_batch.h"
+#include "errc_simd.h"
+
+namespace liberrc {
+
+    //------- BITMASK -------
+
+    namespace bits {
+
+        inline unsigned popcount(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<unsigned>(__builtin_popcountll(x));
+#else
+            x = x - ((x >> 1) & 0x5555555555555555ull);
+            x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+            x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+            return static_cast<unsigned>((x*0x0101010101010101ull) >> 56);
+#endif
+        }
+
+        // Index of the lowest set bit, x must not be 0
+        inline unsigned lowest(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<unsigned>(__builtin_ctzll(x));
+#else
+            return popcount((x & (0 - x)) - 1);
+#endif
+        }
+
+    }
+
+    // Packed bits, bit i is bit i%64 of words[i/64]. Bits past size() in the last word are always 0.
+    class Bitmask {
+
+    public:
+
+        static constexpr std::size_t WORD = 64;
+
+        std::vector<std::uint64_t> words;
+
+        //------- CONSTRUCTORS -------
+
+        Bitmask() = default;
+        explicit Bitmask(std::size_t size, bool set = false)
+                : words((size + WORD - 1)/WORD, set ? ~std::uint64_t(0) : 0), length(size) {
+            clearPadding();
+        };
+
+        //------- MEMBER OPERATORS -------
+
+        bool operator[](std::size_t i) const {
+            return (words[i/WORD] >> (i%WORD)) & 1;
+        }
+
+        Bitmask& operator&=(const Bitmask &m) {
+            checkSize(m);
+            for (std::size_t w = 0; w < words.size(); ++w)
+                words[w] &= m.words[w];
+            return *this;
+        }
+
+        Bitmask& operator|=(const Bitmask &m) {
+            checkSize(m);
+            for (std::size_t w = 0; w < words.size(); ++w)
+                words[w] |= m.words[w];
+            return *this;
+        }
+
+        Bitmask& operator^=(const Bitmask &m) {
+            checkSize(m);
+            for (std::size_t w = 0; w < words.size(); ++w)
+                words[w] ^= m.words[w];
+            return *this;
+        }
+
+        Bitmask operator~() const {
+            Bitmask res(*this);
+            for (std::uint64_t &w : res.words)
+                w = ~w;
+            res.clearPadding();
+            return res;
+        }
+
+        //------- VOID METHODS -------
+
+        void set(std::size_t i, bool bit = true) {
+            const std::uint64_t b = std::uint64_t(1) << (i%WORD);
+            words[i/WORD] = bit ? words[i/WORD] | b : words[i/WORD] & ~b;
+        }
+
+        //------- NON-VOID METHODS -------
+
+        [[nodiscard]] std::size_t size() const {
+            return length;
+        }
+
+        // Number of set bits
+        [[nodiscard]] std::size_t count() const {
+            std::size_t res = 0;
+            for (std::uint64_t w : words)
+                res += bits::popcount(w);
+            return res;
+        }
+
+        [[nodiscard]] bool all() const {
+            return count() == length;
+        }
+
+        [[nodiscard]] bool any() const {
+            for (std::uint64_t w : words)
+                if (w != 0)
+                    return true;
+            return false;
+        }
+
+        [[nodiscard]] bool none() const {
+            return !any();
+        }
+
+        // Calls f(begin, end) for every run of set bits within a word, full words are a single run
+        template <typename F>
+        void forEachRun(F f) const {
+            for (std::size_t w = 0; w < words.size(); ++w) {
+                std::uint64_t word = words[w];
+                const std::size_t base = w*WORD;
+                if (word == ~std::uint64_t(0)) {
+                    f(base, base + WORD);
+                    continue;
+                }
+                while (word != 0) {
+                    const unsigned first = bits::lowest(word);
+                    const std::uint64_t shifted = word >> first;
+                    const unsigned run = ~shifted == 0 ? unsigned(WORD) - first : bits::lowest(~shifted);
+                    f(base + first, base + first + run);
+                    word = first + run >= WORD ? 0 : word & (~std::uint64_t(0) << (first + run));
+                }
+            }
+        }
+
+        // Positions of the set bits in increasing order
+        [[nodiscard]] std::vector<std::size_t> indices() const {
+            std::vector<std::size_t> res;
+            res.reserve(count());
+            forEachRun([&res](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i)
+                    res.push_back(i);
+            });
+            return res;
+        }
+
+    protected:
+
+        std::size_t length = 0;
+
+        void clearPadding() {
+            if (length%WORD != 0)
+                words.back() &= (std::uint64_t(1) << (length%WORD)) - 1;
+        }
+
+        void checkSize(const Bitmask &m) const {
+            if (m.length != length)
+                throw std::invalid_argument("Bitmask sizes must match: " + std::to_string(length) + " and " +
+                                            std::to_string(m.length));
+        }
+
+    };
+
+    inline Bitmask operator&(Bitmask a, const Bitmask &b) {
+        return a &= b;
+    }
+
+    inline Bitmask operator|(Bitmask a, const Bitmask &b) {
+        return a |= b;
+    }
+
+    inline Bitmask operator^(Bitmask a, const Bitmask &b) {
+        return a ^= b;
+    }
+
+    namespace compare {
+
+        enum class Test {
+            CONSISTENT,
+            GREATER,
+            LESS
+        };
+
+        constexpr std::size_t TESTS = 3;
+
+        // Writes the packed results of n comparisons of a with b to (n + 63)/64 words. Scalar kernels compare
+        // every element of a with bv[0], be[0].
+        template <typename T>
+        using CompareKernel = void (*)(const T*, const T*, const T*, const T*, T, std::uint64_t*, std::size_t);
+
+        template <typename T>
+        struct Kernels {
+            simd::Isa isa;
+            std::array<CompareKernel<T>, TESTS> arrays;
+            std::array<CompareKernel<T>, TESTS> scalars;
+        };
+
+        // Keeps k out of template argument deduction, so compare(a, b, 2) works for float arrays
+        template <typename T>
+        using Factor = typename std::common_type<T>::type;
+
+    }
+
+}
+
+#define LIBERRC_KERNELS_FILE "errc_compare_kernels.inl"
+#include "errc_foreach_isa.h"
+
+namespace liberrc {
+
+    namespace compare {
+
+        //------- DISPATCH -------
+
+        template <typename T>
+        const Kernels<T>& kernels(simd::Isa isa) {
+            return simd::onIsa(isa, [](auto target) -> const Kernels<T>& {
+                return compareKernels(target, static_cast<T*>(nullptr));
+            });
+        }
+
+        template <typename T>
+        const Kernels<T>& kernels() {
+            static const Kernels<T> &bound = kernels<T>(simd::activeIsa());
+            return bound;
+        }
+
+        //------- ERRORARRAY HELPERS -------
+
+        template <typename T>
+        Bitmask apply(Test test, const ErrorArray<T> &a, const ErrorArray<T> &b, T k, const Kernels<T> &kernels) {
+            batch::checkSizes(a, b);
+            Bitmask res(a.size());
+            kernels.arrays[static_cast<std::size_t>(test)](a.value.data(), a.error.data(), b.value.data(),
+                                                            b.error.data(), k, res.words.data(), a.size());
+            return res;
+        }
+
+        template <typename T>
+        Bitmask apply(Test test, const ErrorArray<T> &a, const ErrorValue<T, T> &b, T k, const Kernels<T> &kernels) {
+            Bitmask res(a.size());
+            kernels.scalars[static_cast<std::size_t>(test)](a.value.data(), a.error.data(), &b.value, &b.error, k,
+                                                             res.words.data(), a.size());
+            return res;
+        }
+
+    }
+
+    //------- SCALAR COMPARISONS -------
+
+    template <typename T, typename E, typename T1, typename E1>
+    bool consistent(const ErrorValue<T, E> &a, const ErrorValue<T1, E1> &b, double k = 1) {
+        return std::abs(a.value - b.value) <= k*std::hypot(a.error, b.error);
+    }
+
+    template <typename T, typename E, typename T1, typename E1>
+    bool significantlyGreater(const ErrorValue<T, E> &a, const ErrorValue<T1, E1> &b, double k = 1) {
+        return a.value - b.value > k*std::hypot(a.error, b.error);
+    }
+
+    template <typename T, typename E, typename T1, typename E1>
+    bool significantlyLess(const ErrorValue<T, E> &a, const ErrorValue<T1, E1> &b, double k = 1) {
+        return significantlyGreater(b, a, k);
+    }
+
+    //------- ERRORARRAY COMPARISONS -------
+
+    template <typename T>
+    Bitmask consistent(const ErrorArray<T> &a, const ErrorArray<T> &b, compare::Factor<T> k = 1) {
+        return compare::apply(compare::Test::CONSISTENT, a, b, k, compare::kernels<T>());
+    }
+
+    template <typename T>
+    Bitmask consistent(const ErrorArray<T> &a, const ErrorValue<T, T> &b, compare::Factor<T> k = 1) {
+        return compare::apply(compare::Test::CONSISTENT, a, b, k, compare::kernels<T>());
+    }
+
+    template <typename T>
+    Bitmask significantlyGreater(const ErrorArray<T> &a, const ErrorArray<T> &b, compare::Factor<T> k = 1) {
+        return compare::apply(compare::Test::GREATER, a, b, k, compare::kernels<T>());
+    }
+
+    template <typename T>
+    Bitmask significantlyGreater(const ErrorArray<T> &a, const ErrorValue<T, T> &b, compare::Factor<T> k = 1) {
+        return compare::apply(compare::Test::GREATER, a, b, k, compare::kernels<T>());
+    }
+
+    template <typename T>
+    Bitmask significantlyLess(const ErrorArray<T> &a, const ErrorArray<T> &b, compare::Factor<T> k = 1) {
+        return compare::apply(compare::Test::LESS, a, b, k, compare::kernels<T>());
+    }
+
+    template <typename T>
+    Bitmask significantlyLess(const ErrorArray<T> &a, const ErrorValue<T, T> &b, compare::Factor<T> k = 1) {
+        return compare::apply(compare::Test::LESS, a, b, k, compare::kernels<T>());
+    }
+
+    //------- FILTERS -------
+
+    // Elements of x whose bit is set, in order
+    template <typename V>
+    std::vector<V> compact(const std::vector<V> &x, const Bitmask &mask) {
+        if (x.size() != mask.size())
+            throw std::invalid_argument("Compacted sizes must match: " + std::to_string(x.size()) + " and " +
+                                        std::to_string(mask.size()));
+        std::vector<V> res;
+        res.reserve(mask.count());
+        mask.forEachRun([&](std::size_t begin, std::size_t end) {
+            res.insert(res.end(), x.begin() + begin, x.begin() + end);
+        });
+        return res;
+    }
+
+    template <typename T>
+    ErrorArray<T> compact(const ErrorArray<T> &x, const Bitmask &mask) {
+        ErrorArray<T> res;
+        res.value = compact(x.value, mask);
+        res.error = compact(x.error, mask);
+        return res;
+    }
+
+}
+
+#endif //LIBERRC_ERRC_COMPARE_H
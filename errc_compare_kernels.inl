@@ -0,0 +1,63 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+// Comparison kernels, included by errc_foreach_isa.h. Every 64 elements are compared pack by pack and their lane
+// masks are shifted into one output word, so the output is written once and never read.
+
+template <compare::Test TEST, bool BROADCAST, typename P, typename T>
+inline unsigned compareLanes(const T* av, const T* ae, const T* bv, const T* be, T k, std::size_t i) {
+    P a = P::load(av + i), ea = P::load(ae + i);
+    P b = BROADCAST ? P::broadcast(*bv) : P::load(bv + i);
+    P eb = BROADCAST ? P::broadcast(*be) : P::load(be + i);
+    P band = P::broadcast(k)*sqrt(fma(ea, ea, eb*eb));
+    if constexpr (TEST == compare::Test::CONSISTENT)
+        return maskLessEqual(abs(a - b), band);
+    else if constexpr (TEST == compare::Test::GREATER)
+        return maskLess(band, a - b);
+    else
+        return maskLess(band, b - a);
+}
+
+template <typename T, compare::Test TEST, bool BROADCAST>
+void compareKernel(const T* av, const T* ae, const T* bv, const T* be, T k, std::uint64_t* out, std::size_t n) {
+    using P = Pack<T>;
+    std::size_t i = 0;
+    for (std::size_t w = 0; i < n; ++w) {
+        const std::size_t end = std::min(n, i + 64);
+        std::uint64_t word = 0;
+        unsigned shift = 0;
+        for (; i + P::width <= end; i += P::width, shift += P::width)
+            word |= std::uint64_t(compareLanes<TEST, BROADCAST, P>(av, ae, bv, be, k, i)) << shift;
+        for (; i < end; ++i, ++shift)
+            word |= std::uint64_t(compareLanes<TEST, BROADCAST, scalar::Pack<T>>(av, ae, bv, be, k, i)) << shift;
+        out[w] = word;
+    }
+}
+
+template <typename T>
+const compare::Kernels<T>& compareKernels(Target, T*) {
+    using compare::Test;
+    static constexpr compare::Kernels<T> table = {
+            TARGET_ISA,
+            {&compareKernel<T, Test::CONSISTENT, false>, &compareKernel<T, Test::GREATER, false>,
+             &compareKernel<T, Test::LESS, false>},
+            {&compareKernel<T, Test::CONSISTENT, true>, &compareKernel<T, Test::GREATER, true>,
+             &compareKernel<T, Test::LESS, true>}
+    };
+    return table;
+}
@@ -0,0 +1,371 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_COMPLEX_H
+#define LIBERRC_ERRC_COMPLEX_H
+
+#include <complex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "errc.h"
+#include "errc_simd.h"
+
+namespace liberrc {
+
+    namespace complex {
+
+        // Covariance of (re, im) after multiplying the deviation by the complex derivative d = a + ib,
+        // i.e. J*S*J^T with J = [[a, -b], [b, a]]
+        template <typename T>
+        void propagate(T a, T b, T varRe, T varIm, T cov, T &outRe, T &outIm, T &outCov) {
+            T ab = a*b, aa = a*a, bb = b*b;
+            T abc = ab*cov;
+            outRe = aa*varRe + bb*varIm - (abc + abc);
+            outIm = bb*varRe + aa*varIm + (abc + abc);
+            outCov = ab*(varRe - varIm) + (aa - bb)*cov;
+        }
+
+    }
+
+    // Complex value with correlated uncertainty of its real and imaginary parts. Errors are propagated to first
+    // order: a holomorphic function with derivative f' maps the (re, im) covariance S to J*S*J^T, where J is the
+    // 2x2 real matrix of multiplication by f'.
+    template <typename T = long double>
+    class ComplexErrorValue {
+
+        static_assert(std::is_floating_point<T>::value,
+                      "Type of ComplexErrorValue must be float, double or long double");
+
+    public:
+
+        std::complex<T> value;
+        T varRe = 0;
+        T varIm = 0;
+        T covReIm = 0;
+
+        //------- CONSTRUCTORS -------
+
+        [[nodiscard]] ComplexErrorValue() = default;
+
+        [[nodiscard]] ComplexErrorValue(std::complex<T> value_, T errorRe, T errorIm)
+                : value(value_), varRe(errorRe*errorRe), varIm(errorIm*errorIm) {};
+
+        [[nodiscard]] ComplexErrorValue(const ErrorValue<T, T> &re, const ErrorValue<T, T> &im)
+                : ComplexErrorValue(std::complex<T>(re.value, im.value), re.error, im.error) {};
+
+        [[nodiscard]] static ComplexErrorValue fromCovariance(std::complex<T> value_, T varRe_, T varIm_, T cov_) {
+            ComplexErrorValue res;
+            res.value = value_;
+            res.varRe = varRe_, res.varIm = varIm_, res.covReIm = cov_;
+            return res;
+        }
+
+        //------- COMPOUND ASSIGMENT OPERATORS -------
+
+        ComplexErrorValue& operator+=(const ComplexErrorValue &z) {
+            value += z.value;
+            varRe += z.varRe, varIm += z.varIm, covReIm += z.covReIm;
+            return *this;
+        }
+
+        ComplexErrorValue& operator-=(const ComplexErrorValue &z) {
+            value -= z.value;
+            varRe += z.varRe, varIm += z.varIm, covReIm += z.covReIm;
+            return *this;
+        }
+
+        ComplexErrorValue& operator*=(const ComplexErrorValue &z) {
+            combine(z.value, z, value);
+            value *= z.value;
+            return *this;
+        }
+
+        ComplexErrorValue& operator/=(const ComplexErrorValue &z) {
+            std::complex<T> res = value/z.value;
+            combine(static_cast<T>(1)/z.value, z, -res/z.value);
+            value = res;
+            return *this;
+        }
+
+        //------- ARITHMETIC OPERATORS -------
+
+        ComplexErrorValue operator+(const ComplexErrorValue &z) const {
+            ComplexErrorValue res = *this;
+            res += z;
+            return res;
+        }
+
+        ComplexErrorValue operator-(const ComplexErrorValue &z) const {
+            ComplexErrorValue res = *this;
+            res -= z;
+            return res;
+        }
+
+        ComplexErrorValue operator*(const ComplexErrorValue &z) const {
+            ComplexErrorValue res = *this;
+            res *= z;
+            return res;
+        }
+
+        ComplexErrorValue operator/(const ComplexErrorValue &z) const {
+            ComplexErrorValue res = *this;
+            res /= z;
+            return res;
+        }
+
+        ComplexErrorValue operator-() const {
+            return fromCovariance(-value, varRe, varIm, covReIm);
+        }
+
+        //------- NON-VOID METHODS -------
+
+        [[nodiscard]] ErrorValue<T, T> real() const {
+            return ErrorValue<T, T>(value.real(), std::sqrt(varRe));
+        }
+
+        [[nodiscard]] ErrorValue<T, T> imag() const {
+            return ErrorValue<T, T>(value.imag(), std::sqrt(varIm));
+        }
+
+        // Result of a holomorphic function with derivative d at this value
+        [[nodiscard]] ComplexErrorValue apply(std::complex<T> res, std::complex<T> d) const {
+            ComplexErrorValue out;
+            out.value = res;
+            complex::propagate(d.real(), d.imag(), varRe, varIm, covReIm, out.varRe, out.varIm, out.covReIm);
+            return out;
+        }
+
+    protected:
+
+        // Covariance of f(this, z) with partial derivatives dThis and dZ, operands are independent
+        void combine(std::complex<T> dThis, const ComplexErrorValue &z, std::complex<T> dZ) {
+            T r1, i1, c1, r2, i2, c2;
+            complex::propagate(dThis.real(), dThis.imag(), varRe, varIm, covReIm, r1, i1, c1);
+            complex::propagate(dZ.real(), dZ.imag(), z.varRe, z.varIm, z.covReIm, r2, i2, c2);
+            varRe = r1 + r2, varIm = i1 + i2, covReIm = c1 + c2;
+        }
+
+    };
+
+    template <typename T>
+    std::ostream& operator<<(std::ostream& os, const ComplexErrorValue<T> &z) {
+        os << '(' << z.real() << ", " << z.imag() << ')';
+        return os;
+    }
+
+    //------- COMPLEX ERRMATH -------
+
+    template <typename T>
+    ErrorValue<T, T> abs(const ComplexErrorValue<T> &z) {
+        T x = z.value.real(), y = z.value.imag();
+        T r = std::abs(z.value);
+        T variance = (x*x*z.varRe + y*y*z.varIm + 2*x*y*z.covReIm)/(r*r);
+        return ErrorValue<T, T>(r, std::sqrt(variance));
+    }
+
+    template <typename T>
+    ErrorValue<T, T> arg(const ComplexErrorValue<T> &z) {
+        T x = z.value.real(), y = z.value.imag();
+        T r2 = std::norm(z.value);
+        T variance = (y*y*z.varRe + x*x*z.varIm - 2*x*y*z.covReIm)/(r2*r2);
+        return ErrorValue<T, T>(std::arg(z.value), std::sqrt(variance));
+    }
+
+    template <typename T>
+    ComplexErrorValue<T> conj(const ComplexErrorValue<T> &z) {
+        return ComplexErrorValue<T>::fromCovariance(std::conj(z.value), z.varRe, z.varIm, -z.covReIm);
+    }
+
+    template <typename T>
+    ComplexErrorValue<T> exp(const ComplexErrorValue<T> &z) {
+        std::complex<T> res = std::exp(z.value);
+        return z.apply(res, res);
+    }
+
+    template <typename T>
+    ComplexErrorValue<T> log(const ComplexErrorValue<T> &z) {
+        return z.apply(std::log(z.value), static_cast<T>(1)/z.value);
+    }
+
+    template <typename T>
+    ComplexErrorValue<T> polar(const ErrorValue<T, T> &r, const ErrorValue<T, T> &theta) {
+        T c = std::cos(theta.value), s = std::sin(theta.value);
+        T vr = r.error*r.error, vt = theta.error*theta.error;
+        T rr = r.value*r.value;
+        return ComplexErrorValue<T>::fromCovariance(
+                std::polar(r.value, theta.value),
+                c*c*vr + rr*s*s*vt,
+                s*s*vr + rr*c*c*vt,
+                c*s*(vr - rr*vt)
+        );
+    }
+
+    // ComplexErrorValue elements stored in blocks of BLOCK lanes: re, im, varRe, varIm and covReIm of one block
+    // follow each other. Every plane of a block is one or more whole SIMD registers for every supported ISA,
+    // so the kernels need no shuffles and no tail loop; the last block is padded with zeros.
+    template <typename T>
+    class ComplexErrorArray {
+
+        static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+                      "Type of ComplexErrorArray elements must be float or double");
+
+    public:
+
+        static constexpr std::size_t BLOCK = 16;
+        static constexpr std::size_t PLANES = 5;
+        static constexpr std::size_t RE = 0, IM = 1, VAR_RE = 2, VAR_IM = 3, COV = 4;
+
+        //------- CONSTRUCTORS -------
+
+        ComplexErrorArray() = default;
+        explicit ComplexErrorArray(std::size_t size) { resize(size); };
+
+        //------- VOID METHODS -------
+
+        void resize(std::size_t size) {
+            count = size;
+            data.resize(blocks()*BLOCK*PLANES);
+        }
+
+        void set(std::size_t i, const ComplexErrorValue<T> &z) {
+            at(i, RE) = z.value.real();
+            at(i, IM) = z.value.imag();
+            at(i, VAR_RE) = z.varRe;
+            at(i, VAR_IM) = z.varIm;
+            at(i, COV) = z.covReIm;
+        }
+
+        //------- NON-VOID METHODS -------
+
+        [[nodiscard]] ComplexErrorValue<T> operator[](std::size_t i) const {
+            return ComplexErrorValue<T>::fromCovariance(std::complex<T>(at(i, RE), at(i, IM)),
+                                                        at(i, VAR_RE), at(i, VAR_IM), at(i, COV));
+        }
+
+        [[nodiscard]] std::size_t size() const {
+            return count;
+        }
+
+        [[nodiscard]] std::size_t blocks() const {
+            return (count + BLOCK - 1)/BLOCK;
+        }
+
+        [[nodiscard]] T* raw() {
+            return data.data();
+        }
+
+        [[nodiscard]] const T* raw() const {
+            return data.data();
+        }
+
+    protected:
+
+        std::size_t count = 0;
+        std::vector<T> data;
+
+        T& at(std::size_t i, std::size_t plane) {
+            return data[(i/BLOCK*PLANES + plane)*BLOCK + i%BLOCK];
+        }
+
+        const T& at(std::size_t i, std::size_t plane) const {
+            return data[(i/BLOCK*PLANES + plane)*BLOCK + i%BLOCK];
+        }
+
+    };
+
+    namespace batch {
+
+        template <typename T>
+        using ComplexBinaryKernel = void (*)(const T*, const T*, T*, std::size_t);
+
+        template <typename T>
+        using ComplexAccumulateKernel = void (*)(T*, const T*, const T*, std::size_t);
+
+        template <typename T>
+        struct ComplexKernels {
+            simd::Isa isa;
+            ComplexBinaryKernel<T> add;
+            ComplexBinaryKernel<T> mul;
+            ComplexAccumulateKernel<T> multiplyAccumulate;
+        };
+
+    }
+
+}
+
+#define LIBERRC_KERNELS_FILE "errc_complex_kernels.inl"
+#include "errc_foreach_isa.h"
+
+namespace liberrc {
+
+    namespace batch {
+
+        template <typename T>
+        const ComplexKernels<T>& complexKernels(simd::Isa isa) {
+            return simd::onIsa(isa, [](auto target) -> const ComplexKernels<T>& {
+                return complexKernels(target, static_cast<T*>(nullptr));
+            });
+        }
+
+        template <typename T>
+        const ComplexKernels<T>& complexKernels() {
+            static const ComplexKernels<T> &bound = complexKernels<T>(simd::activeIsa());
+            return bound;
+        }
+
+        template <typename T>
+        void checkSizes(const ComplexErrorArray<T> &a, const ComplexErrorArray<T> &b) {
+            if (a.size() != b.size())
+                throw std::invalid_argument("ComplexErrorArray sizes must match: " + std::to_string(a.size()) +
+                                            " and " + std::to_string(b.size()));
+        }
+
+    }
+
+    //------- COMPLEXERRORARRAY OPERATIONS -------
+
+    template <typename T>
+    ComplexErrorArray<T> operator+(const ComplexErrorArray<T> &a, const ComplexErrorArray<T> &b) {
+        batch::checkSizes(a, b);
+        ComplexErrorArray<T> res(a.size());
+        batch::complexKernels<T>().add(a.raw(), b.raw(), res.raw(), a.blocks());
+        return res;
+    }
+
+    template <typename T>
+    ComplexErrorArray<T> operator*(const ComplexErrorArray<T> &a, const ComplexErrorArray<T> &b) {
+        batch::checkSizes(a, b);
+        ComplexErrorArray<T> res(a.size());
+        batch::complexKernels<T>().mul(a.raw(), b.raw(), res.raw(), a.blocks());
+        return res;
+    }
+
+    // acc[i] += a[i]*b[i] for every bin, all three operands are treated as independent
+    template <typename T>
+    void multiplyAccumulate(ComplexErrorArray<T> &acc, const ComplexErrorArray<T> &a, const ComplexErrorArray<T> &b) {
+        batch::checkSizes(acc, a);
+        batch::checkSizes(a, b);
+        batch::complexKernels<T>().multiplyAccumulate(acc.raw(), a.raw(), b.raw(), a.blocks());
+    }
+
+}
+
+#endif //LIBERRC_ERRC_COMPLEX_H
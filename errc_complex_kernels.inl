@@ -0,0 +1,114 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+// Kernels over the blocked ComplexErrorArray layout, included by errc_foreach_isa.h. BLOCK is a multiple of every
+// Pack width, so each block is processed in whole registers.
+
+template <typename T>
+struct ComplexLanes {
+    Pack<T> re, im, varRe, varIm, cov;
+
+    static ComplexLanes load(const T* block, std::size_t lane) {
+        constexpr std::size_t B = ComplexErrorArray<T>::BLOCK;
+        return {Pack<T>::load(block + lane), Pack<T>::load(block + B + lane), Pack<T>::load(block + 2*B + lane),
+                Pack<T>::load(block + 3*B + lane), Pack<T>::load(block + 4*B + lane)};
+    }
+
+    void store(T* block, std::size_t lane) const {
+        constexpr std::size_t B = ComplexErrorArray<T>::BLOCK;
+        re.store(block + lane);
+        im.store(block + B + lane);
+        varRe.store(block + 2*B + lane);
+        varIm.store(block + 3*B + lane);
+        cov.store(block + 4*B + lane);
+    }
+};
+
+// Calls f(blockOffset, lane) for every register of every block
+template <typename T, typename F>
+inline void forEachLane(std::size_t blocks, F f) {
+    constexpr std::size_t B = ComplexErrorArray<T>::BLOCK;
+    constexpr std::size_t stride = B*ComplexErrorArray<T>::PLANES;
+    for (std::size_t b = 0; b < blocks; ++b)
+        for (std::size_t lane = 0; lane < B; lane += Pack<T>::width)
+            f(b*stride, lane);
+}
+
+// Lane-wise complex::propagate, it has to be defined here to be compiled for the ISA of the kernels
+template <typename T>
+inline void propagateLanes(Pack<T> a, Pack<T> b, const ComplexLanes<T> &x,
+                           Pack<T> &outRe, Pack<T> &outIm, Pack<T> &outCov) {
+    Pack<T> ab = a*b, aa = a*a, bb = b*b;
+    Pack<T> abc = ab*x.cov;
+    outRe = aa*x.varRe + bb*x.varIm - (abc + abc);
+    outIm = bb*x.varRe + aa*x.varIm + (abc + abc);
+    outCov = ab*(x.varRe - x.varIm) + (aa - bb)*x.cov;
+}
+
+// Product a*b with covariance b*Sa*b^T + a*Sb*a^T
+template <typename T>
+inline ComplexLanes<T> complexProduct(const ComplexLanes<T> &a, const ComplexLanes<T> &b) {
+    ComplexLanes<T> r;
+    Pack<T> r1, i1, c1, r2, i2, c2;
+    propagateLanes(b.re, b.im, a, r1, i1, c1);
+    propagateLanes(a.re, a.im, b, r2, i2, c2);
+    r.re = a.re*b.re - a.im*b.im;
+    r.im = fma(a.re, b.im, a.im*b.re);
+    r.varRe = r1 + r2;
+    r.varIm = i1 + i2;
+    r.cov = c1 + c2;
+    return r;
+}
+
+template <typename T>
+void complexAddKernel(const T* a, const T* b, T* r, std::size_t blocks) {
+    forEachLane<T>(blocks, [=](std::size_t offset, std::size_t lane) {
+        ComplexLanes<T> x = ComplexLanes<T>::load(a + offset, lane);
+        ComplexLanes<T> y = ComplexLanes<T>::load(b + offset, lane);
+        ComplexLanes<T>{x.re + y.re, x.im + y.im, x.varRe + y.varRe, x.varIm + y.varIm, x.cov + y.cov}
+                .store(r + offset, lane);
+    });
+}
+
+template <typename T>
+void complexMulKernel(const T* a, const T* b, T* r, std::size_t blocks) {
+    forEachLane<T>(blocks, [=](std::size_t offset, std::size_t lane) {
+        ComplexLanes<T> x = ComplexLanes<T>::load(a + offset, lane);
+        ComplexLanes<T> y = ComplexLanes<T>::load(b + offset, lane);
+        complexProduct(x, y).store(r + offset, lane);
+    });
+}
+
+template <typename T>
+void complexMultiplyAccumulateKernel(T* acc, const T* a, const T* b, std::size_t blocks) {
+    forEachLane<T>(blocks, [=](std::size_t offset, std::size_t lane) {
+        ComplexLanes<T> s = ComplexLanes<T>::load(acc + offset, lane);
+        ComplexLanes<T> p = complexProduct(ComplexLanes<T>::load(a + offset, lane),
+                                           ComplexLanes<T>::load(b + offset, lane));
+        ComplexLanes<T>{s.re + p.re, s.im + p.im, s.varRe + p.varRe, s.varIm + p.varIm, s.cov + p.cov}
+                .store(acc + offset, lane);
+    });
+}
+
+template <typename T>
+const batch::ComplexKernels<T>& complexKernels(Target, T*) {
+    static constexpr batch::ComplexKernels<T> table = {
+            TARGET_ISA, &complexAddKernel<T>, &complexMulKernel<T>, &complexMultiplyAccumulateKernel<T>
+    };
+    return table;
+}
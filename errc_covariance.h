@@ -0,0 +1,301 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_COVARIANCE_H
+#define LIBERRC_ERRC_COVARIANCE_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "errc.h"
+#include "errc_dual.h"
+#include "errc_simd.h"
+
+namespace liberrc {
+
+    template <typename T, std::size_t ROWS, std::size_t COLS>
+    using Matrix = std::array<std::array<T, COLS>, ROWS>;
+
+    // Mean vector with a full covariance matrix. Components built from separate ErrorValues are uncorrelated.
+    template <typename T, std::size_t N>
+    class ErrorVector {
+
+        static_assert(std::is_floating_point<T>::value, "Type of ErrorVector must be float, double or long double");
+
+    public:
+
+        std::array<T, N> value{};
+        Matrix<T, N, N> covariance{};
+
+        //------- CONSTRUCTORS -------
+
+        [[nodiscard]] ErrorVector() = default;
+
+        [[nodiscard]] ErrorVector(const std::array<T, N> &value_, const Matrix<T, N, N> &covariance_)
+                : value(value_), covariance(covariance_) {};
+
+        [[nodiscard]] explicit ErrorVector(const std::array<ErrorValue<T, T>, N> &x) {
+            for (std::size_t i = 0; i < N; ++i) {
+                value[i] = x[i].value;
+                covariance[i][i] = x[i].error*x[i].error;
+            }
+        }
+
+        //------- NON-VOID METHODS -------
+
+        // Component i with its marginal error
+        [[nodiscard]] ErrorValue<T, T> operator[](std::size_t i) const {
+            return ErrorValue<T, T>(value[i], std::sqrt(covariance[i][i]));
+        }
+
+        [[nodiscard]] T correlation(std::size_t i, std::size_t j) const {
+            return covariance[i][j]/std::sqrt(covariance[i][i]*covariance[j][j]);
+        }
+
+    };
+
+    namespace covariance {
+
+        // J*S*J^T
+        template <typename T, std::size_t M, std::size_t N>
+        Matrix<T, M, M> sandwich(const Matrix<T, M, N> &j, const Matrix<T, N, N> &s) {
+            Matrix<T, M, N> js{};
+            for (std::size_t m = 0; m < M; ++m)
+                for (std::size_t k = 0; k < N; ++k)
+                    for (std::size_t n = 0; n < N; ++n)
+                        js[m][n] += j[m][k]*s[k][n];
+            Matrix<T, M, M> res{};
+            for (std::size_t m = 0; m < M; ++m)
+                for (std::size_t p = m; p < M; ++p) {
+                    for (std::size_t n = 0; n < N; ++n)
+                        res[m][p] += js[m][n]*j[p][n];
+                    res[p][m] = res[m][p];
+                }
+            return res;
+        }
+
+        // Number of outputs of f when called with N duals
+        template <typename T, std::size_t N, typename F>
+        constexpr std::size_t outputs() {
+            using R = std::decay_t<decltype(std::declval<F>()(std::declval<const std::array<Dual<T, N>, N>&>()))>;
+            return std::tuple_size<R>::value;
+        }
+
+        // Value and Jacobian of f at x from a single evaluation with duals
+        template <typename T, std::size_t N, typename F, std::size_t M = outputs<T, N, F>()>
+        void linearize(F &&f, const std::array<T, N> &x, std::array<T, M> &value, Matrix<T, M, N> &jacobian) {
+            const auto y = f(variables(x));
+            for (std::size_t m = 0; m < M; ++m) {
+                value[m] = y[m].value;
+                for (std::size_t n = 0; n < N; ++n)
+                    jacobian[m][n] = y[m].grad[n];
+            }
+        }
+
+    }
+
+    // f takes a const std::array<Dual<T, N>, N>& and returns an array-like of M duals, generic lambdas written
+    // for std::array<double, N> usually work as is
+    template <typename T, std::size_t N, typename F, std::size_t M = covariance::outputs<T, N, F>()>
+    Matrix<T, M, N> jacobian(F &&f, const std::array<T, N> &x) {
+        std::array<T, M> value;
+        Matrix<T, M, N> res;
+        covariance::linearize(f, x, value, res);
+        return res;
+    }
+
+    // First order propagation of the covariance of x through f: f(x) with covariance J*S*J^T
+    template <typename T, std::size_t N, typename F, std::size_t M = covariance::outputs<T, N, F>()>
+    ErrorVector<T, M> propagateCovariance(F &&f, const ErrorVector<T, N> &x) {
+        ErrorVector<T, M> res;
+        Matrix<T, M, N> j;
+        covariance::linearize(f, x.value, res.value, j);
+        res.covariance = covariance::sandwich(j, x.covariance);
+        return res;
+    }
+
+    // Blocked array of ErrorVectors for batches of small problems. Every block of BLOCK vectors stores N planes of
+    // means followed by the upper triangle of the covariance, one plane per (i, j) with i <= j, so each matrix
+    // element of BLOCK problems fills whole SIMD registers.
+    template <typename T, std::size_t N>
+    class ErrorVectorArray {
+
+        static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+                      "Type of ErrorVectorArray elements must be float or double");
+
+    public:
+
+        static constexpr std::size_t BLOCK = 16;
+        static constexpr std::size_t PLANES = N + N*(N + 1)/2;
+
+        // Plane of covariance element (i, j)
+        static constexpr std::size_t plane(std::size_t i, std::size_t j) {
+            return i > j ? plane(j, i) : N + i*N - i*(i - 1)/2 + (j - i);
+        }
+
+        //------- CONSTRUCTORS -------
+
+        ErrorVectorArray() = default;
+        explicit ErrorVectorArray(std::size_t size) { resize(size); };
+
+        //------- VOID METHODS -------
+
+        void resize(std::size_t size) {
+            count = size;
+            data.resize(blocks()*BLOCK*PLANES);
+        }
+
+        void set(std::size_t i, const ErrorVector<T, N> &x) {
+            for (std::size_t a = 0; a < N; ++a) {
+                at(i, a) = x.value[a];
+                for (std::size_t b = a; b < N; ++b)
+                    at(i, plane(a, b)) = x.covariance[a][b];
+            }
+        }
+
+        //------- NON-VOID METHODS -------
+
+        [[nodiscard]] ErrorVector<T, N> operator[](std::size_t i) const {
+            ErrorVector<T, N> res;
+            for (std::size_t a = 0; a < N; ++a) {
+                res.value[a] = at(i, a);
+                for (std::size_t b = 0; b < N; ++b)
+                    res.covariance[a][b] = at(i, plane(a, b));
+            }
+            return res;
+        }
+
+        [[nodiscard]] std::size_t size() const {
+            return count;
+        }
+
+        [[nodiscard]] std::size_t blocks() const {
+            return (count + BLOCK - 1)/BLOCK;
+        }
+
+        [[nodiscard]] T* raw() {
+            return data.data();
+        }
+
+        [[nodiscard]] const T* raw() const {
+            return data.data();
+        }
+
+    protected:
+
+        std::size_t count = 0;
+        std::vector<T> data;
+
+        T& at(std::size_t i, std::size_t p) {
+            return data[(i/BLOCK*PLANES + p)*BLOCK + i%BLOCK];
+        }
+
+        const T& at(std::size_t i, std::size_t p) const {
+            return data[(i/BLOCK*PLANES + p)*BLOCK + i%BLOCK];
+        }
+
+    };
+
+    namespace batch {
+
+        // Writes the covariance planes of J*S*J^T for every block. jacobian holds M*N planes of BLOCK elements per
+        // block, x and r are ErrorVectorArray<T, N> and ErrorVectorArray<T, M> storage.
+        template <typename T>
+        using SandwichKernel = void (*)(const T*, const T*, T*, std::size_t);
+
+        template <typename T>
+        struct CovarianceKernels {
+            simd::Isa isa;
+            SandwichKernel<T> sandwich;
+        };
+
+    }
+
+}
+
+#define LIBERRC_KERNELS_FILE "errc_covariance_kernels.inl"
+#include "errc_foreach_isa.h"
+
+namespace liberrc {
+
+    namespace batch {
+
+        template <typename T, std::size_t N, std::size_t M>
+        const CovarianceKernels<T>& covarianceKernels(simd::Isa isa) {
+            return simd::onIsa(isa, [](auto target) -> const CovarianceKernels<T>& {
+                return covarianceKernels(target, static_cast<T*>(nullptr), std::integral_constant<std::size_t, N>(),
+                                         std::integral_constant<std::size_t, M>());
+            });
+        }
+
+        template <typename T, std::size_t N, std::size_t M>
+        const CovarianceKernels<T>& covarianceKernels() {
+            static const CovarianceKernels<T> &bound = covarianceKernels<T, N, M>(simd::activeIsa());
+            return bound;
+        }
+
+        // Blocks per Jacobian buffer, so the buffer stays in cache for millions of problems
+        constexpr std::size_t COVARIANCE_CHUNK = 64;
+
+    }
+
+    // Batched propagateCovariance. f is evaluated with scalar duals for every vector, the J*S*J^T products then
+    // run in SIMD kernels over whole blocks.
+    template <typename T, std::size_t N, typename F, std::size_t M = covariance::outputs<T, N, F>()>
+    ErrorVectorArray<T, M> propagateCovariance(F &&f, const ErrorVectorArray<T, N> &x,
+                                               const batch::CovarianceKernels<T> &kernels =
+                                                       batch::covarianceKernels<T, N, M>()) {
+        constexpr std::size_t B = ErrorVectorArray<T, N>::BLOCK;
+        constexpr std::size_t CHUNK = batch::COVARIANCE_CHUNK;
+        ErrorVectorArray<T, M> res(x.size());
+        std::vector<T> jac(std::min(x.blocks(), CHUNK)*M*N*B);
+        std::array<T, N> mean;
+        std::array<T, M> value;
+        Matrix<T, M, N> j;
+
+        for (std::size_t first = 0; first < x.blocks(); first += CHUNK) {
+            std::size_t blocks = std::min(CHUNK, x.blocks() - first);
+            std::fill(jac.begin(), jac.end(), T(0));
+            for (std::size_t b = 0; b < blocks; ++b) {
+                const T* in = x.raw() + (first + b)*ErrorVectorArray<T, N>::PLANES*B;
+                T* out = res.raw() + (first + b)*ErrorVectorArray<T, M>::PLANES*B;
+                std::size_t lanes = std::min(B, x.size() - (first + b)*B);
+                for (std::size_t l = 0; l < lanes; ++l) {
+                    for (std::size_t n = 0; n < N; ++n)
+                        mean[n] = in[n*B + l];
+                    covariance::linearize(f, mean, value, j);
+                    for (std::size_t m = 0; m < M; ++m) {
+                        out[m*B + l] = value[m];
+                        for (std::size_t n = 0; n < N; ++n)
+                            jac[(b*M*N + m*N + n)*B + l] = j[m][n];
+                    }
+                }
+            }
+            kernels.sandwich(jac.data(), x.raw() + first*ErrorVectorArray<T, N>::PLANES*B,
+                             res.raw() + first*ErrorVectorArray<T, M>::PLANES*B, blocks);
+        }
+        return res;
+    }
+
+}
+
+#endif //LIBERRC_ERRC_COVARIANCE_H
@@ -0,0 +1,59 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+// J*S*J^T over blocked ErrorVectorArrays, included by errc_foreach_isa.h. Every lane of a register is a separate
+// problem, so the small matrix products need no shuffles.
+
+template <typename T, std::size_t N, std::size_t M>
+void sandwichKernel(const T* jacobian, const T* x, T* r, std::size_t blocks) {
+    constexpr std::size_t B = ErrorVectorArray<T, N>::BLOCK;
+    for (std::size_t b = 0; b < blocks; ++b) {
+        const T* jb = jacobian + b*M*N*B;
+        const T* xb = x + b*ErrorVectorArray<T, N>::PLANES*B;
+        T* rb = r + b*ErrorVectorArray<T, M>::PLANES*B;
+        for (std::size_t lane = 0; lane < B; lane += Pack<T>::width) {
+            Pack<T> s[N][N], j[M][N], js[M][N];
+            for (std::size_t k = 0; k < N; ++k)
+                for (std::size_t n = k; n < N; ++n)
+                    s[k][n] = s[n][k] = Pack<T>::load(xb + ErrorVectorArray<T, N>::plane(k, n)*B + lane);
+            for (std::size_t m = 0; m < M; ++m)
+                for (std::size_t n = 0; n < N; ++n)
+                    j[m][n] = Pack<T>::load(jb + (m*N + n)*B + lane);
+            for (std::size_t m = 0; m < M; ++m)
+                for (std::size_t n = 0; n < N; ++n) {
+                    js[m][n] = Pack<T>::zero();
+                    for (std::size_t k = 0; k < N; ++k)
+                        js[m][n] = fma(j[m][k], s[k][n], js[m][n]);
+                }
+            for (std::size_t m = 0; m < M; ++m)
+                for (std::size_t p = m; p < M; ++p) {
+                    Pack<T> acc = Pack<T>::zero();
+                    for (std::size_t n = 0; n < N; ++n)
+                        acc = fma(js[m][n], j[p][n], acc);
+                    acc.store(rb + ErrorVectorArray<T, M>::plane(m, p)*B + lane);
+                }
+        }
+    }
+}
+
+template <typename T, std::size_t N, std::size_t M>
+const batch::CovarianceKernels<T>& covarianceKernels(Target, T*, std::integral_constant<std::size_t, N>,
+                                                     std::integral_constant<std::size_t, M>) {
+    static constexpr batch::CovarianceKernels<T> table = {TARGET_ISA, &sandwichKernel<T, N, M>};
+    return table;
+}
@@ -0,0 +1,348 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_DUAL_H
+#define LIBERRC_ERRC_DUAL_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+namespace liberrc {
+
+    // Forward-mode dual number: a value and its partial derivatives with respect to N variables known at compile
+    // time. Generic code written for double works for Dual through the overloads below and computes the value and
+    // the whole gradient in one evaluation.
+    template <typename T, std::size_t N>
+    class Dual {
+
+        static_assert(std::is_floating_point<T>::value, "Type of Dual value must be float, double or long double");
+
+    public:
+
+        using value_type = T;
+
+        T value;
+        std::array<T, N> grad;
+
+        //------- CONSTRUCTORS -------
+
+        Dual() : value(0), grad{} {};
+        Dual(T value_) : value(value_), grad{} {};
+
+        // Independent variable number i
+        Dual(T value_, std::size_t i) : value(value_), grad{} {
+            grad[i] = 1;
+        };
+
+        // Value f(x) with derivative df/dx = d
+        [[nodiscard]] Dual chain(T f, T d) const {
+            Dual res(f);
+            for (std::size_t i = 0; i < N; ++i)
+                res.grad[i] = d*grad[i];
+            return res;
+        }
+
+        //------- COMPOUND ASSIGMENT OPERATORS -------
+
+        Dual& operator+=(const Dual &x) {
+            value += x.value;
+            for (std::size_t i = 0; i < N; ++i)
+                grad[i] += x.grad[i];
+            return *this;
+        }
+
+        Dual& operator-=(const Dual &x) {
+            value -= x.value;
+            for (std::size_t i = 0; i < N; ++i)
+                grad[i] -= x.grad[i];
+            return *this;
+        }
+
+        Dual& operator*=(const Dual &x) {
+            for (std::size_t i = 0; i < N; ++i)
+                grad[i] = grad[i]*x.value + value*x.grad[i];
+            value *= x.value;
+            return *this;
+        }
+
+        Dual& operator/=(const Dual &x) {
+            T inv = 1/x.value;
+            value *= inv;
+            for (std::size_t i = 0; i < N; ++i)
+                grad[i] = (grad[i] - value*x.grad[i])*inv;
+            return *this;
+        }
+
+        //------- ARITHMETIC OPERATORS -------
+
+        Dual operator+() const {
+            return *this;
+        }
+
+        Dual operator-() const {
+            return chain(-value, -1);
+        }
+
+    };
+
+    template <typename T>
+    struct IsDual : std::false_type {};
+
+    template <typename T, std::size_t N>
+    struct IsDual<Dual<T, N>> : std::true_type {};
+
+    //------- ARITHMETIC OPERATORS -------
+
+    template <typename T, std::size_t N>
+    Dual<T, N> operator+(Dual<T, N> a, const Dual<T, N> &b) { return a += b; }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> operator-(Dual<T, N> a, const Dual<T, N> &b) { return a -= b; }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> operator*(Dual<T, N> a, const Dual<T, N> &b) { return a *= b; }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> operator/(Dual<T, N> a, const Dual<T, N> &b) { return a /= b; }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> operator+(Dual<T, N> a, typename Dual<T, N>::value_type b) { a.value += b; return a; }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> operator+(typename Dual<T, N>::value_type a, Dual<T, N> b) { b.value += a; return b; }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> operator-(Dual<T, N> a, typename Dual<T, N>::value_type b) { a.value -= b; return a; }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> operator-(typename Dual<T, N>::value_type a, const Dual<T, N> &b) { return b.chain(a - b.value, -1); }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> operator*(const Dual<T, N> &a, typename Dual<T, N>::value_type b) { return a.chain(a.value*b, b); }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> operator*(typename Dual<T, N>::value_type a, const Dual<T, N> &b) { return b.chain(a*b.value, a); }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> operator/(const Dual<T, N> &a, typename Dual<T, N>::value_type b) { return a.chain(a.value/b, 1/b); }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> operator/(typename Dual<T, N>::value_type a, const Dual<T, N> &b) {
+        T v = a/b.value;
+        return b.chain(v, -v/b.value);
+    }
+
+    //------- COMPARISON OPERATORS -------
+
+    template <typename T, std::size_t N>
+    bool operator<(const Dual<T, N> &a, const Dual<T, N> &b) { return a.value < b.value; }
+
+    template <typename T, std::size_t N>
+    bool operator>(const Dual<T, N> &a, const Dual<T, N> &b) { return a.value > b.value; }
+
+    template <typename T, std::size_t N>
+    bool operator<=(const Dual<T, N> &a, const Dual<T, N> &b) { return a.value <= b.value; }
+
+    template <typename T, std::size_t N>
+    bool operator>=(const Dual<T, N> &a, const Dual<T, N> &b) { return a.value >= b.value; }
+
+    template <typename T, std::size_t N>
+    bool operator<(const Dual<T, N> &a, typename Dual<T, N>::value_type b) { return a.value < b; }
+
+    template <typename T, std::size_t N>
+    bool operator>(const Dual<T, N> &a, typename Dual<T, N>::value_type b) { return a.value > b; }
+
+    template <typename T, std::size_t N>
+    bool operator<=(const Dual<T, N> &a, typename Dual<T, N>::value_type b) { return a.value <= b; }
+
+    template <typename T, std::size_t N>
+    bool operator>=(const Dual<T, N> &a, typename Dual<T, N>::value_type b) { return a.value >= b; }
+
+    //------- DUAL MATH FUNCTIONS -------
+
+    template <typename T, std::size_t N>
+    Dual<T, N> sin(const Dual<T, N> &x) { return x.chain(std::sin(x.value), std::cos(x.value)); }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> cos(const Dual<T, N> &x) { return x.chain(std::cos(x.value), -std::sin(x.value)); }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> tan(const Dual<T, N> &x) {
+        T c = std::cos(x.value);
+        return x.chain(std::tan(x.value), 1/(c*c));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> asin(const Dual<T, N> &x) {
+        return x.chain(std::asin(x.value), 1/std::sqrt(1 - x.value*x.value));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> acos(const Dual<T, N> &x) {
+        return x.chain(std::acos(x.value), -1/std::sqrt(1 - x.value*x.value));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> atan(const Dual<T, N> &x) {
+        return x.chain(std::atan(x.value), 1/(1 + x.value*x.value));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> atan2(const Dual<T, N> &y, const Dual<T, N> &x) {
+        T r2 = x.value*x.value + y.value*y.value;
+        Dual<T, N> res(std::atan2(y.value, x.value));
+        for (std::size_t i = 0; i < N; ++i)
+            res.grad[i] = (x.value*y.grad[i] - y.value*x.grad[i])/r2;
+        return res;
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> sinh(const Dual<T, N> &x) { return x.chain(std::sinh(x.value), std::cosh(x.value)); }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> cosh(const Dual<T, N> &x) { return x.chain(std::cosh(x.value), std::sinh(x.value)); }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> tanh(const Dual<T, N> &x) {
+        T t = std::tanh(x.value);
+        return x.chain(t, 1 - t*t);
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> asinh(const Dual<T, N> &x) {
+        return x.chain(std::asinh(x.value), 1/std::sqrt(x.value*x.value + 1));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> acosh(const Dual<T, N> &x) {
+        return x.chain(std::acosh(x.value), 1/std::sqrt(x.value*x.value - 1));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> atanh(const Dual<T, N> &x) {
+        return x.chain(std::atanh(x.value), 1/(1 - x.value*x.value));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> erf(const Dual<T, N> &x) {
+        return x.chain(std::erf(x.value), 2*std::exp(-x.value*x.value)/std::sqrt(static_cast<T>(M_PI)));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> erfc(const Dual<T, N> &x) {
+        return x.chain(std::erfc(x.value), -2*std::exp(-x.value*x.value)/std::sqrt(static_cast<T>(M_PI)));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> exp(const Dual<T, N> &x) {
+        T e = std::exp(x.value);
+        return x.chain(e, e);
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> exp2(const Dual<T, N> &x) {
+        T e = std::exp2(x.value);
+        return x.chain(e, e*std::log(static_cast<T>(2)));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> expm1(const Dual<T, N> &x) { return x.chain(std::expm1(x.value), std::exp(x.value)); }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> log(const Dual<T, N> &x) { return x.chain(std::log(x.value), 1/x.value); }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> log2(const Dual<T, N> &x) {
+        return x.chain(std::log2(x.value), 1/(x.value*std::log(static_cast<T>(2))));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> log10(const Dual<T, N> &x) {
+        return x.chain(std::log10(x.value), 1/(x.value*std::log(static_cast<T>(10))));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> log1p(const Dual<T, N> &x) { return x.chain(std::log1p(x.value), 1/(1 + x.value)); }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> sqrt(const Dual<T, N> &x) {
+        T s = std::sqrt(x.value);
+        return x.chain(s, 1/(2*s));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> cbrt(const Dual<T, N> &x) {
+        T c = std::cbrt(x.value);
+        return x.chain(c, 1/(3*c*c));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> abs(const Dual<T, N> &x) { return x.value < 0 ? -x : x; }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> pow(const Dual<T, N> &x, typename Dual<T, N>::value_type y) {
+        return x.chain(std::pow(x.value, y), y*std::pow(x.value, y - 1));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> pow(typename Dual<T, N>::value_type x, const Dual<T, N> &y) {
+        T p = std::pow(x, y.value);
+        return y.chain(p, p*std::log(x));
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> pow(const Dual<T, N> &x, const Dual<T, N> &y) {
+        T p = std::pow(x.value, y.value);
+        T dx = y.value*std::pow(x.value, y.value - 1);
+        T dy = x.value > 0 ? p*std::log(x.value) : 0;
+        Dual<T, N> res(p);
+        for (std::size_t i = 0; i < N; ++i)
+            res.grad[i] = dx*x.grad[i] + dy*y.grad[i];
+        return res;
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> hypot(const Dual<T, N> &x, const Dual<T, N> &y) {
+        T h = std::hypot(x.value, y.value);
+        Dual<T, N> res(h);
+        for (std::size_t i = 0; i < N; ++i)
+            res.grad[i] = (x.value*x.grad[i] + y.value*y.grad[i])/h;
+        return res;
+    }
+
+    template <typename T, std::size_t N>
+    Dual<T, N> fma(const Dual<T, N> &x, const Dual<T, N> &y, const Dual<T, N> &z) {
+        return x*y + z;
+    }
+
+    //------- VARIABLES -------
+
+    // Seeds N independent variables at point x
+    template <typename T, std::size_t N>
+    std::array<Dual<T, N>, N> variables(const std::array<T, N> &x) {
+        std::array<Dual<T, N>, N> res;
+        for (std::size_t i = 0; i < N; ++i)
+            res[i] = Dual<T, N>(x[i], i);
+        return res;
+    }
+
+}
+
+#endif //LIBERRC_ERRC_DUAL_H
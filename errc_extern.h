@@ -0,0 +1,82 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_EXTERN_H
+#define LIBERRC_ERRC_EXTERN_H
+
+// Explicit instantiation declarations of ErrorValue<T, T> and its errmath for float, double and long double.
+// errc.h includes this file when LIBERRC_EXTERN_TEMPLATES is defined, which linking the liberrc_instances target
+// does; the definitions are compiled once in errc_instantiate.cpp, so translation units stop emitting them.
+
+#include "errc.h"
+
+#ifdef LIBERRC_INSTRUMENT
+#error "LIBERRC_EXTERN_TEMPLATES can not be combined with LIBERRC_INSTRUMENT, liberrc_instances is built without it"
+#endif
+
+#define LIBERRC_INSTANCE_UNARY(EXTERN, T, f) EXTERN template auto f(const ErrorValue<T, T>&);
+
+#define LIBERRC_INSTANCE_BINARY(EXTERN, T, f) EXTERN template auto f(const ErrorValue<T, T>&, const ErrorValue<T, T>&);
+
+#ifndef LIBERRC_NOT_ADD_ERRMATH
+#define LIBERRC_INSTANCE_ERRMATH(EXTERN, T) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, sin) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, cos) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, tan) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, asin) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, acos) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, atan) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, sinh) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, cosh) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, tanh) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, asinh) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, acosh) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, atanh) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, erf) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, erfc) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, exp) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, exp2) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, expm1) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, log) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, log2) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, log10) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, log1p) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, sqrt) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, cbrt) \
+    LIBERRC_INSTANCE_UNARY(EXTERN, T, abs) \
+    LIBERRC_INSTANCE_BINARY(EXTERN, T, atan2) \
+    LIBERRC_INSTANCE_BINARY(EXTERN, T, hypot) \
+    LIBERRC_INSTANCE_BINARY(EXTERN, T, pow) \
+    EXTERN template auto pow(const ErrorValue<T, T>&, T); \
+    EXTERN template auto pow(const ErrorValue<T, T>&, int); \
+    EXTERN template auto fma(const ErrorValue<T, T>&, const ErrorValue<T, T>&, const ErrorValue<T, T>&);
+#else
+#define LIBERRC_INSTANCE_ERRMATH(EXTERN, T)
+#endif
+
+// EXTERN is extern for the declarations and empty for the definitions
+#define LIBERRC_INSTANCES(EXTERN, T) \
+    EXTERN template class ErrorValue<T, T>; \
+    EXTERN template std::ostream& operator<<(std::ostream&, const ErrorValue<T, T>&); \
+    LIBERRC_INSTANCE_ERRMATH(EXTERN, T)
+
+LIBERRC_INSTANCES(extern, float)
+LIBERRC_INSTANCES(extern, double)
+LIBERRC_INSTANCES(extern, long double)
+
+#endif //LIBERRC_ERRC_EXTERN_H
@@ -0,0 +1,278 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_FIT_H
+#define LIBERRC_ERRC_FIT_H
+
+// Streaming weighted least squares. Points (x, y ± e) with weight 1/e^2 are reduced to the moments of the normal
+// equations, sum(w*u^j) for j <= 2K, sum(w*y*u^j) for j <= K and sum(w*y^2) with u = x - origin, so the data is
+// never stored and partial accumulators of different threads or files can be merged.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "errc.h"
+#include "errc_batch.h"
+#include "errc_covariance.h"
+#include "errc_parallel.h"
+#include "errc_simd.h"
+
+namespace liberrc::fit {
+
+    template <std::size_t K>
+    struct Moments {
+        static constexpr std::size_t POWERS = 2*K + 1;
+        static constexpr std::size_t SIZE = POWERS + K + 2;
+    };
+
+    // Adds the moments of n points to m, errors must be positive
+    template <typename T>
+    using MomentsKernel = void (*)(const T*, const T*, const T*, std::size_t, T, double*);
+
+    template <typename T>
+    struct Kernels {
+        simd::Isa isa;
+        MomentsKernel<T> moments;
+    };
+
+}
+
+#define LIBERRC_KERNELS_FILE "errc_fit_kernels.inl"
+#include "errc_foreach_isa.h"
+
+namespace liberrc::fit {
+
+    template <typename T, std::size_t K>
+    const Kernels<T>& kernels(simd::Isa isa) {
+        return simd::onIsa(isa, [](auto target) -> const Kernels<T>& {
+            return fitKernels(target, static_cast<T*>(nullptr), std::integral_constant<std::size_t, K>());
+        });
+    }
+
+    template <typename T, std::size_t K>
+    const Kernels<T>& kernels() {
+        static const Kernels<T> &bound = kernels<T, K>(simd::activeIsa());
+        return bound;
+    }
+
+    //------- RESULT -------
+
+    // Coefficients of the powers of (x - origin) with their covariance
+    template <typename T, std::size_t K>
+    struct Result {
+        ErrorVector<T, K + 1> coefficients;
+        T origin = 0;
+        double chiSquared = 0;
+        std::uint64_t degreesOfFreedom = 0;
+
+        [[nodiscard]] ErrorValue<T, T> operator[](std::size_t i) const {
+            return coefficients[i];
+        }
+
+        // Fitted curve at x, its error includes the correlations of the coefficients
+        [[nodiscard]] ErrorValue<T, T> operator()(T x) const {
+            std::array<T, K + 1> powers;
+            T u = x - origin, p = 1, value = 0, variance = 0;
+            for (std::size_t i = 0; i <= K; ++i, p *= u) {
+                powers[i] = p;
+                value += coefficients.value[i]*p;
+            }
+            for (std::size_t i = 0; i <= K; ++i)
+                for (std::size_t j = 0; j <= K; ++j)
+                    variance += powers[i]*coefficients.covariance[i][j]*powers[j];
+            return ErrorValue<T, T>(value, std::sqrt(variance));
+        }
+    };
+
+    //------- ACCUMULATOR -------
+
+    // Polynomial fit of degree K, K = 0 is the weighted mean and ignores x
+    template <typename T, std::size_t K>
+    class Accumulator {
+
+        static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+                      "Type of fitted data must be float or double");
+
+    public:
+
+        static constexpr std::size_t POWERS = Moments<K>::POWERS, SIZE = Moments<K>::SIZE;
+
+        //------- CONSTRUCTORS -------
+
+        explicit Accumulator(T origin_ = 0, const Kernels<T> &kernels_ = fit::kernels<T, K>())
+                : origin(origin_), kernels(&kernels_) {};
+
+        //------- VOID METHODS -------
+
+        void push(T x, T y, T error) {
+            if (!(error > 0))
+                throw std::invalid_argument("Fitted points must have positive errors, got " + std::to_string(error));
+            add(&x, &y, &error, 1);
+        }
+
+        void push(T x, const ErrorValue<T, T> &y) {
+            push(x, y.value, y.error);
+        }
+
+        // x may be null for K = 0
+        void add(const T* x, const T* y, const T* error, std::size_t n) {
+            kernels->moments(x, y, error, n, origin, moments.data());
+            count += n;
+        }
+
+        void add(const std::vector<T> &x, const ErrorArray<T> &y) {
+            if (K > 0 && x.size() != y.size())
+                throw std::invalid_argument("Fit sizes must match: " + std::to_string(x.size()) + " and " +
+                                            std::to_string(y.size()));
+            add(K > 0 ? x.data() : nullptr, y.value.data(), y.error.data(), y.size());
+        }
+
+        // Merges the partial sums of another stream of the same fit
+        Accumulator& operator+=(const Accumulator &a) {
+            if (a.origin != origin)
+                throw std::invalid_argument("Merged fits must have the same origin: " + std::to_string(origin) +
+                                            " and " + std::to_string(a.origin));
+            for (std::size_t j = 0; j < SIZE; ++j)
+                moments[j] += a.moments[j];
+            count += a.count;
+            return *this;
+        }
+
+        //------- NON-VOID METHODS -------
+
+        [[nodiscard]] std::uint64_t size() const {
+            return count;
+        }
+
+        // Solves the normal equations, their inverse is the covariance of the coefficients
+        [[nodiscard]] Result<T, K> solve() const {
+            if (count <= K)
+                throw std::runtime_error("Polynomial fit of degree " + std::to_string(K) + " needs more than " +
+                                         std::to_string(count) + " points");
+            Matrix<double, K + 1, K + 1> inverse = invert();
+            std::array<double, K + 1> c{};
+            double ct = 0;
+            for (std::size_t i = 0; i <= K; ++i) {
+                for (std::size_t j = 0; j <= K; ++j)
+                    c[i] += inverse[i][j]*moments[POWERS + j];
+                ct += c[i]*moments[POWERS + i];
+            }
+
+            Result<T, K> res;
+            res.origin = origin;
+            for (std::size_t i = 0; i <= K; ++i) {
+                res.coefficients.value[i] = static_cast<T>(c[i]);
+                for (std::size_t j = 0; j <= K; ++j)
+                    res.coefficients.covariance[i][j] = static_cast<T>(inverse[i][j]);
+            }
+            res.chiSquared = std::max(0.0, moments[SIZE - 1] - ct);
+            res.degreesOfFreedom = count - (K + 1);
+            return res;
+        }
+
+    protected:
+
+        T origin;
+        const Kernels<T>* kernels;
+        std::array<double, SIZE> moments{};
+        std::uint64_t count = 0;
+
+        // Inverse of the normal matrix A[i][j] = sum(w*u^(i + j)) through its Cholesky factor L
+        Matrix<double, K + 1, K + 1> invert() const {
+            Matrix<double, K + 1, K + 1> l{}, inverse{};
+            for (std::size_t i = 0; i <= K; ++i)
+                for (std::size_t j = 0; j <= i; ++j) {
+                    double s = moments[i + j];
+                    for (std::size_t k = 0; k < j; ++k)
+                        s -= l[i][k]*l[j][k];
+                    if (i == j) {
+                        if (!(s > 0))
+                            throw std::runtime_error("Normal equations of the fit are singular");
+                        l[i][i] = std::sqrt(s);
+                    } else {
+                        l[i][j] = s/l[j][j];
+                    }
+                }
+            // Columns of A^-1 from L*L^T*x = e_c
+            for (std::size_t c = 0; c <= K; ++c) {
+                std::array<double, K + 1> z{};
+                for (std::size_t i = 0; i <= K; ++i) {
+                    double s = i == c ? 1 : 0;
+                    for (std::size_t k = 0; k < i; ++k)
+                        s -= l[i][k]*z[k];
+                    z[i] = s/l[i][i];
+                }
+                for (std::size_t i = K + 1; i-- > 0;) {
+                    double s = z[i];
+                    for (std::size_t k = i + 1; k <= K; ++k)
+                        s -= l[k][i]*inverse[k][c];
+                    inverse[i][c] = s/l[i][i];
+                }
+            }
+            return inverse;
+        }
+
+    };
+
+    //------- ONE-PASS FITS -------
+
+    // Smallest number of points per thread worth a partial accumulator
+    constexpr std::size_t MIN_POINTS_PER_THREAD = 1 << 16;
+
+    // Fits in parallel, one partial accumulator per thread, merged in a fixed order
+    template <std::size_t K, typename T>
+    Result<T, K> polynomial(const std::vector<T> &x, const ErrorArray<T> &y, T origin = 0, unsigned threads = 0) {
+        if (K > 0 && x.size() != y.size())
+            throw std::invalid_argument("Fit sizes must match: " + std::to_string(x.size()) + " and " +
+                                        std::to_string(y.size()));
+        const std::size_t n = y.size();
+        const std::size_t parts = std::max<std::size_t>(1, std::min<std::size_t>(parallel::threadCount(threads),
+                                                                                 n/MIN_POINTS_PER_THREAD));
+        std::vector<Accumulator<T, K>> partials(parts, Accumulator<T, K>(origin));
+        parallel::forRanges(parts, threads, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t p = begin; p < end; ++p) {
+                std::size_t first = n*p/parts, last = n*(p + 1)/parts;
+                partials[p].add(K > 0 ? x.data() + first : nullptr, y.value.data() + first,
+                                y.error.data() + first, last - first);
+            }
+        });
+        for (std::size_t p = 1; p < parts; ++p)
+            partials[0] += partials[p];
+        return partials[0].solve();
+    }
+
+    // y = a + b*(x - origin)
+    template <typename T>
+    Result<T, 1> linear(const std::vector<T> &x, const ErrorArray<T> &y, T origin = 0, unsigned threads = 0) {
+        return polynomial<1>(x, y, origin, threads);
+    }
+
+    template <typename T>
+    Result<T, 0> weightedMean(const ErrorArray<T> &y, unsigned threads = 0) {
+        return polynomial<0>(std::vector<T>(), y, T(0), threads);
+    }
+
+}
+
+#endif //LIBERRC_ERRC_FIT_H
@@ -0,0 +1,78 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+// Moments of weighted least squares, included by errc_foreach_isa.h. Registers accumulate at most CHUNK elements
+// before they are added to the double moments, so float input keeps its precision over long streams.
+
+template <typename T, std::size_t K>
+void momentsKernel(const T* x, const T* y, const T* e, std::size_t n, T origin, double* m) {
+    using P = Pack<T>;
+    constexpr std::size_t S = fit::Moments<K>::POWERS, M = fit::Moments<K>::SIZE;
+    constexpr std::size_t CHUNK = 1024;
+    const P o = P::broadcast(origin), one = P::broadcast(1);
+
+    std::size_t i = 0;
+    const std::size_t vectorEnd = n - n%P::width;
+    while (i < vectorEnd) {
+        const std::size_t end = std::min(vectorEnd, i + CHUNK);
+        P acc[M];
+        for (P &a : acc)
+            a = P::zero();
+        for (; i < end; i += P::width) {
+            P err = P::load(e + i), yv = P::load(y + i);
+            P w = one/(err*err);
+            P wy = w*yv;
+            acc[M - 1] = fma(wy, yv, acc[M - 1]);
+            acc[0] = acc[0] + w;
+            acc[S] = acc[S] + wy;
+            if constexpr (K > 0) {
+                P u = P::load(x + i) - o;
+                for (std::size_t j = 1; j < S; ++j) {
+                    w = w*u;
+                    acc[j] = acc[j] + w;
+                    if (j <= K) {
+                        wy = wy*u;
+                        acc[S + j] = acc[S + j] + wy;
+                    }
+                }
+            }
+        }
+        for (std::size_t j = 0; j < M; ++j)
+            m[j] += hsum(acc[j]);
+    }
+    for (; i < n; ++i) {
+        double w = 1/(static_cast<double>(e[i])*e[i]);
+        double u = K > 0 ? static_cast<double>(x[i]) - origin : 0;
+        double wy = w*y[i];
+        m[M - 1] += wy*y[i];
+        for (std::size_t j = 0; j < S; ++j) {
+            m[j] += w;
+            w *= u;
+            if (j <= K) {
+                m[S + j] += wy;
+                wy *= u;
+            }
+        }
+    }
+}
+
+template <typename T, std::size_t K>
+const fit::Kernels<T>& fitKernels(Target, T*, std::integral_constant<std::size_t, K>) {
+    static constexpr fit::Kernels<T> table = {TARGET_ISA, &momentsKernel<T, K>};
+    return table;
+}
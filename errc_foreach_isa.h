@@ -0,0 +1,79 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+// No include guard: this file is included once per kernel file. Define LIBERRC_KERNELS_FILE to the kernel
+// file name before including it, the kernels are then compiled into liberrc::simd::<isa> for every ISA.
+
+#ifndef LIBERRC_KERNELS_FILE
+#error "LIBERRC_KERNELS_FILE must be defined before including errc_foreach_isa.h"
+#endif
+
+namespace liberrc::simd::scalar {
+#include LIBERRC_KERNELS_FILE
+}
+
+#ifdef LIBERRC_SIMD_X86
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+namespace liberrc::simd::sse2 {
+#include LIBERRC_KERNELS_FILE
+}
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+namespace liberrc::simd::avx2 {
+#include LIBERRC_KERNELS_FILE
+}
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+namespace liberrc::simd::avx512 {
+#include LIBERRC_KERNELS_FILE
+}
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif //LIBERRC_SIMD_X86
+
+#undef LIBERRC_KERNELS_FILE
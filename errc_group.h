@@ -0,0 +1,398 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_GROUP_H
+#define LIBERRC_ERRC_GROUP_H
+
+// Inverse-variance weighted mean per key. Keys live in an open-addressing table with linear probing whose slots
+// hold the high half of the hash and the group index. Keys, hashes and sums are flat arrays indexed by group; the
+// sums of a group are one record, since rows hit groups at random and separate arrays would cost a cache miss each.
+// Sums are taken about the first value of each group, which keeps the chi-squared accurate for means far from
+// zero. Partial aggregates of different threads or files can be merged.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "errc.h"
+#include "errc_batch.h"
+#include "errc_parallel.h"
+
+namespace liberrc {
+
+    // Result of GroupedMean::emit, one element per group
+    template <typename Key, typename T>
+    struct Groups {
+        std::vector<Key> keys;
+        ErrorArray<T> means;
+        std::vector<std::uint64_t> rows;
+        // sum((x - mean)^2/e^2), compare with rows - 1 to check the consistency of a group
+        std::vector<double> chiSquared;
+
+        [[nodiscard]] std::size_t size() const {
+            return keys.size();
+        }
+    };
+
+    template <typename Key, typename T = double, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    class GroupedMean;
+
+    template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    GroupedMean<Key, T, Hash, KeyEqual> groupedMean(const Key* keys, const T* values, const T* errors, std::size_t n,
+                                                    unsigned threads = 0);
+
+    template <typename Key, typename T, typename Hash, typename KeyEqual>
+    class GroupedMean {
+
+        static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+                      "Type of grouped values must be float or double");
+
+    public:
+
+        //------- CONSTRUCTORS -------
+
+        explicit GroupedMean(std::size_t groups = 0, const Hash &hash_ = Hash(), const KeyEqual &equal_ = KeyEqual())
+                : hash(hash_), equal(equal_) {
+            reserve(groups);
+        };
+
+        //------- VOID METHODS -------
+
+        void add(const Key &key, T value, T error) {
+            if (!valid(value, error))
+                throw std::invalid_argument(invalidRow(value, error));
+            accumulate(insert(key, hashOf(key)), value, error);
+        }
+
+        void add(const Key &key, const ErrorValue<T, T> &x) {
+            add(key, x.value, x.error);
+        }
+
+        // Works on blocks of rows in three passes so that the cache misses of a block overlap: hash the keys and
+        // prefetch their slots, find the groups and prefetch their sums, then accumulate
+        void add(const Key* keys_, const T* values, const T* errors, std::size_t n) {
+            checkRows(values, errors, n);
+            std::array<std::uint64_t, BLOCK> hashes_;
+            std::array<std::size_t, BLOCK> groups;
+            for (std::size_t b = 0; b < n; b += BLOCK) {
+                const std::size_t m = std::min(BLOCK, n - b);
+                for (std::size_t j = 0; j < m; ++j) {
+                    hashes_[j] = hashOf(keys_[b + j]);
+                    prefetch(&slots[hashes_[j] & (slots.size() - 1)]);
+                }
+                for (std::size_t j = 0; j < m; ++j) {
+                    groups[j] = insert(keys_[b + j], hashes_[j]);
+                    prefetch(&sums[groups[j]]);
+                }
+                for (std::size_t j = 0; j < m; ++j)
+                    accumulate(groups[j], values[b + j], errors[b + j]);
+            }
+        }
+
+        void add(const std::vector<Key> &keys_, const ErrorArray<T> &x) {
+            if (keys_.size() != x.size())
+                throw std::invalid_argument("Grouped keys and values sizes must match: " +
+                                            std::to_string(keys_.size()) + " and " + std::to_string(x.size()));
+            add(keys_.data(), x.value.data(), x.error.data(), x.size());
+        }
+
+        // Room for groups keys without rehashing
+        void reserve(std::size_t groups) {
+            if (groups > MAX_GROUPS)
+                throw std::length_error("GroupedMean holds at most " + std::to_string(MAX_GROUPS) + " groups");
+            std::size_t capacity = std::max<std::size_t>(slots.size(), MIN_SLOTS);
+            while (capacity < 2*groups)
+                capacity *= 2;
+            if (capacity != slots.size())
+                rehash(capacity);
+            keys.reserve(groups);
+            hashes.reserve(groups);
+            sums.reserve(groups);
+        }
+
+        // Merges the groups of another partial aggregate, matching keys are combined
+        GroupedMean& operator+=(const GroupedMean &a) {
+            for (std::size_t g = 0; g < a.size(); ++g)
+                combine(insert(a.keys[g], a.hashes[g]), a.sums[g]);
+            return *this;
+        }
+
+        //------- NON-VOID METHODS -------
+
+        // Number of groups
+        [[nodiscard]] std::size_t size() const {
+            return keys.size();
+        }
+
+        [[nodiscard]] bool empty() const {
+            return keys.empty();
+        }
+
+        [[nodiscard]] bool contains(const Key &key) const {
+            return find(key, hashOf(key)) != NOT_FOUND;
+        }
+
+        // Number of rows added to the group of key, 0 if there is none
+        [[nodiscard]] std::uint64_t rows(const Key &key) const {
+            std::size_t g = find(key, hashOf(key));
+            return g == NOT_FOUND ? 0 : sums[g].rows;
+        }
+
+        // Weighted mean of the group of key, throws std::out_of_range if there is none
+        [[nodiscard]] ErrorValue<T, T> at(const Key &key) const {
+            std::size_t g = find(key, hashOf(key));
+            if (g == NOT_FOUND)
+                throw std::out_of_range("GroupedMean has no group with this key");
+            return mean(g);
+        }
+
+        // Calls f(key, mean, rows) for every group in emit order
+        template <typename F>
+        void forEach(F f) const {
+            for (std::size_t g = 0; g < keys.size(); ++g)
+                f(keys[g], mean(g), sums[g].rows);
+        }
+
+        // Groups in the order their keys were first added, or merged
+        [[nodiscard]] Groups<Key, T> emit() const {
+            Groups<Key, T> res;
+            res.keys = keys;
+            res.means = ErrorArray<T>(keys.size());
+            res.rows.resize(keys.size());
+            res.chiSquared.resize(keys.size());
+            for (std::size_t g = 0; g < keys.size(); ++g) {
+                const Sums &s = sums[g];
+                ErrorValue<T, T> m = mean(g);
+                res.means.set(g, m.value, m.error);
+                res.rows[g] = s.rows;
+                res.chiSquared[g] = std::max(0.0, s.square - s.sum*s.sum/s.weight);
+            }
+            return res;
+        }
+
+    protected:
+
+        static constexpr std::size_t BLOCK = 64, MIN_SLOTS = 16;
+        static constexpr std::size_t MAX_GROUPS = std::numeric_limits<std::uint32_t>::max() - 1;
+        static constexpr std::size_t NOT_FOUND = std::numeric_limits<std::size_t>::max();
+        static constexpr std::uint64_t INDEX = 0xffffffffu, TAG = ~INDEX;
+
+        template <typename K, typename U, typename H, typename E>
+        friend GroupedMean<K, U, H, E> groupedMean(const K*, const U*, const U*, std::size_t, unsigned);
+
+        Hash hash;
+        KeyEqual equal;
+        // Slot is the high half of the hash and the group index + 1, 0 if empty
+        std::vector<std::uint64_t> slots;
+        // Sums of w, w*u and w*u^2 with u = x - origin
+        struct Sums {
+            double origin = 0, weight = 0, sum = 0, square = 0;
+            std::uint64_t rows = 0;
+        };
+
+        // Groups
+        std::vector<Key> keys;
+        std::vector<std::uint64_t> hashes;
+        std::vector<Sums> sums;
+
+        static void prefetch(const void* p) {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(p);
+#else
+            (void)p;
+#endif
+        }
+
+        // An infinite error adds weight 0 and a group of only such rows a 0/0 mean, a NaN value poisons its group
+        static bool valid(T value, T error) {
+            return std::isfinite(value) && std::isfinite(error) && error > 0;
+        }
+
+        static std::string invalidRow(T value, T error) {
+            return "Grouped values must be finite with finite positive errors, got " + std::to_string(value) +
+                   " with error " + std::to_string(error);
+        }
+
+        static void checkRows(const T* values, const T* errors, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i)
+                if (!valid(values[i], errors[i]))
+                    throw std::invalid_argument(invalidRow(values[i], errors[i]) + " at " + std::to_string(i));
+        }
+
+        // std::hash of integers is often the identity, mix it so that both halves of the hash are usable
+        std::uint64_t hashOf(const Key &key) const {
+            std::uint64_t h = static_cast<std::uint64_t>(hash(key));
+            h = (h ^ (h >> 30))*0xbf58476d1ce4e5b9u;
+            h = (h ^ (h >> 27))*0x94d049bb133111ebu;
+            return h ^ (h >> 31);
+        }
+
+        std::size_t find(const Key &key, std::uint64_t h) const {
+            const std::size_t mask = slots.size() - 1;
+            for (std::size_t i = h & mask;; i = (i + 1) & mask) {
+                std::uint64_t s = slots[i];
+                if (s == 0)
+                    return NOT_FOUND;
+                if ((s & TAG) == (h & TAG) && equal(keys[(s & INDEX) - 1], key))
+                    return (s & INDEX) - 1;
+            }
+        }
+
+        // Index of the group of key, created empty if missing
+        std::size_t insert(const Key &key, std::uint64_t h) {
+            if (2*(keys.size() + 1) > slots.size()) {
+                if (keys.size() >= MAX_GROUPS)
+                    throw std::length_error("GroupedMean holds at most " + std::to_string(MAX_GROUPS) + " groups");
+                rehash(2*slots.size());
+            }
+            const std::size_t mask = slots.size() - 1;
+            for (std::size_t i = h & mask;; i = (i + 1) & mask) {
+                std::uint64_t s = slots[i];
+                if (s == 0) {
+                    slots[i] = (h & TAG) | (keys.size() + 1);
+                    keys.push_back(key);
+                    hashes.push_back(h);
+                    sums.emplace_back();
+                    return keys.size() - 1;
+                }
+                if ((s & TAG) == (h & TAG) && equal(keys[(s & INDEX) - 1], key))
+                    return (s & INDEX) - 1;
+            }
+        }
+
+        // Appends the groups of a, none of which may be in this table
+        void append(const GroupedMean &a) {
+            const std::size_t mask = slots.size() - 1;
+            for (std::size_t g = 0; g < a.size(); ++g) {
+                std::size_t i = a.hashes[g] & mask;
+                while (slots[i] != 0)
+                    i = (i + 1) & mask;
+                slots[i] = (a.hashes[g] & TAG) | (keys.size() + 1);
+                keys.push_back(a.keys[g]);
+            }
+            hashes.insert(hashes.end(), a.hashes.begin(), a.hashes.end());
+            sums.insert(sums.end(), a.sums.begin(), a.sums.end());
+        }
+
+        void rehash(std::size_t capacity) {
+            slots.assign(capacity, 0);
+            const std::size_t mask = capacity - 1;
+            for (std::size_t g = 0; g < hashes.size(); ++g) {
+                std::size_t i = hashes[g] & mask;
+                while (slots[i] != 0)
+                    i = (i + 1) & mask;
+                slots[i] = (hashes[g] & TAG) | (g + 1);
+            }
+        }
+
+        void accumulate(std::size_t g, T value, T error) {
+            Sums &s = sums[g];
+            if (s.rows == 0)
+                s.origin = value;
+            double w = 1/(static_cast<double>(error)*error), u = value - s.origin, wu = w*u;
+            s.weight += w;
+            s.sum += wu;
+            s.square += wu*u;
+            ++s.rows;
+        }
+
+        // Moves the sums of a about the origin of g: u = ua + d
+        void combine(std::size_t g, const Sums &a) {
+            Sums &s = sums[g];
+            if (s.rows == 0)
+                s.origin = a.origin;
+            double d = a.origin - s.origin;
+            s.square += a.square + d*(2*a.sum + d*a.weight);
+            s.sum += a.sum + d*a.weight;
+            s.weight += a.weight;
+            s.rows += a.rows;
+        }
+
+        ErrorValue<T, T> mean(std::size_t g) const {
+            const Sums &s = sums[g];
+            return ErrorValue<T, T>(static_cast<T>(s.origin + s.sum/s.weight), static_cast<T>(1/std::sqrt(s.weight)));
+        }
+
+    };
+
+    //------- PARALLEL AGGREGATION -------
+
+    // Smallest number of rows per thread worth a partial aggregate
+    constexpr std::size_t MIN_ROWS_PER_THREAD = 1 << 16;
+
+    // Every thread splits its rows by the high bits of the hash into one partial aggregate per partition, then every
+    // partition is merged on its own thread in a fixed order and the disjoint partitions are concatenated. Groups are
+    // emitted by partition, then in the order of first appearance.
+    template <typename Key, typename T, typename Hash, typename KeyEqual>
+    GroupedMean<Key, T, Hash, KeyEqual> groupedMean(const Key* keys, const T* values, const T* errors, std::size_t n,
+                                                    unsigned threads) {
+        using Aggregate = GroupedMean<Key, T, Hash, KeyEqual>;
+        const std::size_t parts = std::max<std::size_t>(1, std::min<std::size_t>(parallel::threadCount(threads),
+                                                                                 n/MIN_ROWS_PER_THREAD));
+        Aggregate res;
+        if (parts == 1) {
+            res.add(keys, values, errors, n);
+            return res;
+        }
+        Aggregate::checkRows(values, errors, n);
+
+        std::vector<Aggregate> partials(parts*parts);
+        parallel::forRanges(parts, threads, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t t = begin; t < end; ++t)
+                for (std::size_t i = n*t/parts, last = n*(t + 1)/parts; i < last; ++i) {
+                    std::uint64_t h = res.hashOf(keys[i]);
+                    Aggregate &partial = partials[t*parts + ((h >> 32)*parts >> 32)];
+                    partial.accumulate(partial.insert(keys[i], h), values[i], errors[i]);
+                }
+        });
+        parallel::forRanges(parts, threads, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t p = begin; p < end; ++p)
+                for (std::size_t t = 1; t < parts; ++t) {
+                    partials[p] += partials[t*parts + p];
+                    partials[t*parts + p] = Aggregate();
+                }
+        });
+
+        std::size_t total = 0;
+        for (std::size_t p = 0; p < parts; ++p)
+            total += partials[p].size();
+        res.reserve(total);
+        for (std::size_t p = 0; p < parts; ++p)
+            res.append(partials[p]);
+        return res;
+    }
+
+    template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    GroupedMean<Key, T, Hash, KeyEqual> groupedMean(const std::vector<Key> &keys, const ErrorArray<T> &x,
+                                                    unsigned threads = 0) {
+        if (keys.size() != x.size())
+            throw std::invalid_argument("Grouped keys and values sizes must match: " + std::to_string(keys.size()) +
+                                        " and " + std::to_string(x.size()));
+        return groupedMean<Key, T, Hash, KeyEqual>(keys.data(), x.value.data(), x.error.data(), x.size(), threads);
+    }
+
+}
+
+#endif //LIBERRC_ERRC_GROUP_H
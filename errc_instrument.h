@@ -0,0 +1,256 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_INSTRUMENT_H
+#define LIBERRC_ERRC_INSTRUMENT_H
+
+// Error-budget instrumentation. Compile with -D LIBERRC_INSTRUMENT to count ErrorValue operator and errmath calls
+// and to track which named inputs contribute to the variance of every result. Without it the hooks in errc.h
+// expand to nothing, ErrorValue has no extra members, counters stay at zero and all variance is reported unnamed.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace liberrc::instrument {
+
+    enum class Op {
+        ADD, SUB, MUL, DIV, NEG, INC, DEC,
+        SIN, COS, TAN, ASIN, ACOS, ATAN, ATAN2,
+        SINH, COSH, TANH, ASINH, ACOSH, ATANH,
+        ERF, ERFC, EXP, LOG10, EXP2, LOG2, LOG, EXPM1, LOG1P, LOGN,
+        POW, SQRT, CBRT, HYPOT, ABS, FMA,
+        PROPAGATE,
+        COUNT
+    };
+
+    constexpr std::size_t OP_COUNT = static_cast<std::size_t>(Op::COUNT);
+
+    inline const char* opName(Op op) {
+        static constexpr const char* names[OP_COUNT] = {
+                "add", "sub", "mul", "div", "neg", "inc", "dec",
+                "sin", "cos", "tan", "asin", "acos", "atan", "atan2",
+                "sinh", "cosh", "tanh", "asinh", "acosh", "atanh",
+                "erf", "erfc", "exp", "log10", "exp2", "log2", "log", "expm1", "log1p", "logn",
+                "pow", "sqrt", "cbrt", "hypot", "abs", "fma",
+                "propagate"
+        };
+        return names[static_cast<std::size_t>(op)];
+    }
+
+    constexpr bool enabled() {
+#ifdef LIBERRC_INSTRUMENT
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    //------- CALL COUNTERS -------
+
+    struct Snapshot {
+        std::array<std::uint64_t, OP_COUNT> calls{};
+
+        std::uint64_t operator[](Op op) const {
+            return calls[static_cast<std::size_t>(op)];
+        }
+
+        Snapshot operator-(const Snapshot &s) const {
+            Snapshot res;
+            for (std::size_t i = 0; i < OP_COUNT; ++i)
+                res.calls[i] = calls[i] - s.calls[i];
+            return res;
+        }
+    };
+
+    inline std::array<std::atomic<std::uint64_t>, OP_COUNT>& counters() {
+        static std::array<std::atomic<std::uint64_t>, OP_COUNT> c{};
+        return c;
+    }
+
+    inline void count(Op op) {
+        counters()[static_cast<std::size_t>(op)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline Snapshot snapshot() {
+        Snapshot res;
+        for (std::size_t i = 0; i < OP_COUNT; ++i)
+            res.calls[i] = counters()[i].load(std::memory_order_relaxed);
+        return res;
+    }
+
+    inline void reset() {
+        for (std::atomic<std::uint64_t> &c : counters())
+            c.store(0, std::memory_order_relaxed);
+    }
+
+    // One "name calls" line per operation in a fixed order, so two dumps can be compared with diff
+    inline void dump(std::ostream &os, const Snapshot &s = snapshot()) {
+        for (std::size_t i = 0; i < OP_COUNT; ++i)
+            os << opName(static_cast<Op>(i)) << ' ' << s.calls[i] << '\n';
+    }
+
+    //------- VARIANCE BUDGET -------
+
+    // Variance contribution of every named input, sorted by input id. Id 0 collects unnamed inputs.
+    using Budget = std::vector<std::pair<unsigned, double>>;
+
+    inline std::vector<std::string>& inputNames() {
+        static std::vector<std::string> names = {"<unnamed>"};
+        return names;
+    }
+
+    inline std::mutex& inputNamesMutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    inline unsigned inputId(const std::string &name) {
+        std::lock_guard<std::mutex> lock(inputNamesMutex());
+        std::vector<std::string> &names = inputNames();
+        auto it = std::find(names.begin(), names.end(), name);
+        if (it != names.end())
+            return static_cast<unsigned>(it - names.begin());
+        names.push_back(name);
+        return static_cast<unsigned>(names.size() - 1);
+    }
+
+    inline std::string inputName(unsigned id) {
+        std::lock_guard<std::mutex> lock(inputNamesMutex());
+        return inputNames()[id];
+    }
+
+    template <typename EV>
+    Budget contributions(const EV &ev) {
+#ifdef LIBERRC_INSTRUMENT
+        if (!ev.budget.empty())
+            return ev.budget;
+#endif
+        double variance = static_cast<double>(ev.error)*static_cast<double>(ev.error);
+        if (variance == 0)
+            return {};
+        return {{0, variance}};
+    }
+
+    // Adds scale*b into a, both sorted by id
+    inline void accumulate(Budget &a, const Budget &b, double scale) {
+        Budget res;
+        res.reserve(a.size() + b.size());
+        std::size_t i = 0, j = 0;
+        while (i < a.size() || j < b.size()) {
+            if (j == b.size() || (i < a.size() && a[i].first < b[j].first)) {
+                res.push_back(a[i++]);
+            } else if (i == a.size() || b[j].first < a[i].first) {
+                res.emplace_back(b[j].first, scale*b[j].second);
+                ++j;
+            } else {
+                res.emplace_back(a[i].first, a[i].second + scale*b[j].second);
+                ++i, ++j;
+            }
+        }
+        a.swap(res);
+    }
+
+    // Marks ev as a named input: its whole variance is attributed to name from now on
+    template <typename EV>
+    void name(EV &ev, const std::string &label) {
+#ifdef LIBERRC_INSTRUMENT
+        ev.budget = {{inputId(label), static_cast<double>(ev.error)*static_cast<double>(ev.error)}};
+#else
+        (void)ev, (void)label;
+#endif
+    }
+
+    struct Contribution {
+        std::string name;
+        double variance;
+        double fraction;
+    };
+
+    // Largest contribution first
+    template <typename EV>
+    std::vector<Contribution> attribution(const EV &ev) {
+        Budget budget = contributions(ev);
+        double total = 0;
+        for (const std::pair<unsigned, double> &c : budget)
+            total += c.second;
+        std::vector<Contribution> res;
+        for (const std::pair<unsigned, double> &c : budget)
+            res.push_back({inputName(c.first), c.second, total > 0 ? c.second/total : 0});
+        std::stable_sort(res.begin(), res.end(), [](const Contribution &a, const Contribution &b) {
+            return a.variance > b.variance;
+        });
+        return res;
+    }
+
+    template <typename EV>
+    void dumpAttribution(std::ostream &os, const EV &ev) {
+        for (const Contribution &c : attribution(ev))
+            os << c.name << ' ' << c.variance << ' ' << c.fraction << '\n';
+    }
+
+    //------- ERRORVALUE HOOKS -------
+
+    inline void traceOperands(Budget &) {}
+
+    template <typename EV, typename D, typename... Args>
+    void traceOperands(Budget &budget, const EV &ev, D d2, const Args&... args) {
+        accumulate(budget, contributions(ev), static_cast<double>(d2));
+        traceOperands(budget, args...);
+    }
+
+    // Counts op and sets res budget to sum of d2*budget over (operand, squared partial derivative) pairs
+    template <typename R, typename... Args>
+    void trace(Op op, R &res, const Args&... args) {
+        count(op);
+        Budget budget;
+        traceOperands(budget, args...);
+        res.budget.swap(budget);
+    }
+
+    // trace for a function of all xs with partial derivatives grad
+    template <typename R, typename G, typename... EVs>
+    void traceGradient(Op op, R &res, const G &grad, const EVs&... xs) {
+        count(op);
+        Budget budget;
+        std::size_t i = 0;
+        auto add = [&](const auto &x) {
+            double g = static_cast<double>(grad[i++]);
+            accumulate(budget, contributions(x), g*g);
+        };
+        (add(xs), ...);
+        res.budget.swap(budget);
+    }
+
+    template <typename X, typename R>
+    R traceUnary(Op op, const X &x, R res) {
+        double e = static_cast<double>(x.error);
+        double r = static_cast<double>(res.error);
+        trace(op, res, x, e == 0 ? 0 : (r*r)/(e*e));
+        return res;
+    }
+
+}
+
+#endif //LIBERRC_ERRC_INSTRUMENT_H
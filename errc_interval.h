@@ -0,0 +1,278 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_INTERVAL_H
+#define LIBERRC_ERRC_INTERVAL_H
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "errc.h"
+#include "errc_batch.h"
+#include "errc_parallel.h"
+
+namespace liberrc {
+
+    // How the error of a stored measurement e and of a query eq widen the accepted distance |value - query|
+    enum class Band {
+        OVERLAP,    // k*(e + eq): the k-sigma bands overlap
+        CONSISTENT  // k*sqrt(e^2 + eq^2): the difference is within k standard deviations
+    };
+
+    // Matches of a batch of queries: indices[offsets[i]..offsets[i + 1]) belong to query i
+    struct IntervalMatches {
+        std::vector<std::size_t> offsets;
+        std::vector<std::size_t> indices;
+
+        [[nodiscard]] std::size_t size() const {
+            return offsets.empty() ? 0 : offsets.size() - 1;
+        }
+
+        [[nodiscard]] std::vector<std::size_t> operator[](std::size_t i) const {
+            return std::vector<std::size_t>(indices.begin() + offsets[i], indices.begin() + offsets[i + 1]);
+        }
+    };
+
+    // Index over the uncertainty bands of an ErrorArray. Measurements are sorted by value into blocks of BLOCK,
+    // an implicit binary tree over the blocks keeps the largest error of every subtree. A query descends only
+    // into subtrees whose value range, widened by their largest error, can reach it, so any k and query error
+    // can be used with one index.
+    template <typename T>
+    class IntervalIndex {
+
+        static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+                      "Type of IntervalIndex elements must be float or double");
+
+    public:
+
+        static constexpr std::size_t BLOCK = 64;
+
+        // Smallest number of queries per thread worth a separate range
+        static constexpr std::size_t MIN_QUERIES_PER_THREAD = 1024;
+
+        //------- CONSTRUCTORS -------
+
+        IntervalIndex() = default;
+
+        // Sorts in parallel, O(n log n)
+        explicit IntervalIndex(const ErrorArray<T> &x, unsigned threads = 0) : index(x.size()) {
+            std::iota(index.begin(), index.end(), std::size_t(0));
+            parallel::sort(index, [&x](std::size_t a, std::size_t b) { return x.value[a] < x.value[b]; }, threads);
+            value.resize(x.size());
+            error.resize(x.size());
+            for (std::size_t i = 0; i < x.size(); ++i) {
+                value[i] = x.value[index[i]];
+                error[i] = std::abs(x.error[index[i]]);
+            }
+
+            std::vector<T> level((x.size() + BLOCK - 1)/BLOCK);
+            for (std::size_t b = 0; b < level.size(); ++b)
+                level[b] = *std::max_element(error.begin() + b*BLOCK, error.begin() + std::min((b + 1)*BLOCK, size()));
+            maxError.push_back(std::move(level));
+            while (maxError.back().size() > 1) {
+                const std::vector<T> &below = maxError.back();
+                std::vector<T> above((below.size() + 1)/2);
+                for (std::size_t i = 0; i < above.size(); ++i)
+                    above[i] = 2*i + 1 < below.size() ? std::max(below[2*i], below[2*i + 1]) : below[2*i];
+                maxError.push_back(std::move(above));
+            }
+        }
+
+        //------- SINGLE QUERIES -------
+
+        // Measurements whose band [min(), max()] contains x, in order of value
+        [[nodiscard]] std::vector<std::size_t> stab(T x) const {
+            return query(x, 0, 1, Band::OVERLAP);
+        }
+
+        [[nodiscard]] std::vector<std::size_t> overlapping(const ErrorValue<T, T> &q, T k = 1) const {
+            return query(q.value, q.error, k, Band::OVERLAP);
+        }
+
+        [[nodiscard]] std::vector<std::size_t> consistent(const ErrorValue<T, T> &q, T k = 1) const {
+            return query(q.value, q.error, k, Band::CONSISTENT);
+        }
+
+        [[nodiscard]] std::vector<std::size_t> query(T q, T eq, T k, Band band) const {
+            std::vector<std::size_t> res;
+            visit(q, std::abs(eq), k, band, [&](std::size_t i) { res.push_back(index[i]); });
+            return res;
+        }
+
+        //------- BATCHED QUERIES -------
+
+        // Queries run in order of value, so consecutive queries walk the same part of the tree
+        [[nodiscard]] IntervalMatches stab(const std::vector<T> &x, unsigned threads = 0) const {
+            return query(x, std::vector<T>(), 1, Band::OVERLAP, threads);
+        }
+
+        [[nodiscard]] IntervalMatches overlapping(const ErrorArray<T> &q, T k = 1, unsigned threads = 0) const {
+            return query(q.value, q.error, k, Band::OVERLAP, threads);
+        }
+
+        [[nodiscard]] IntervalMatches consistent(const ErrorArray<T> &q, T k = 1, unsigned threads = 0) const {
+            return query(q.value, q.error, k, Band::CONSISTENT, threads);
+        }
+
+        // eq may be empty for queries without error
+        [[nodiscard]] IntervalMatches query(const std::vector<T> &q, const std::vector<T> &eq, T k, Band band,
+                                            unsigned threads = 0) const {
+            const std::size_t n = q.size();
+            std::vector<std::size_t> order(n);
+            std::iota(order.begin(), order.end(), std::size_t(0));
+            parallel::sort(order, [&q](std::size_t a, std::size_t b) { return q[a] < q[b]; }, threads);
+
+            IntervalMatches res;
+            res.offsets.assign(n + 1, 0);
+            forParts(n, threads, [&](std::size_t first, std::size_t last, std::vector<std::size_t> &found) {
+                for (std::size_t s = first; s < last; ++s) {
+                    std::size_t j = order[s], before = found.size();
+                    visit(q[j], eq.empty() ? T(0) : std::abs(eq[j]), k, band,
+                          [&](std::size_t i) { found.push_back(index[i]); });
+                    res.offsets[j + 1] = found.size() - before;
+                }
+            }, [&](std::size_t first, std::size_t last, const std::vector<std::size_t> &found) {
+                std::size_t pos = 0;
+                for (std::size_t s = first; s < last; ++s) {
+                    std::size_t j = order[s];
+                    std::copy_n(found.begin() + pos, res.offsets[j + 1] - res.offsets[j],
+                                res.indices.begin() + res.offsets[j]);
+                    pos += res.offsets[j + 1] - res.offsets[j];
+                }
+            }, [&]() {
+                std::partial_sum(res.offsets.begin(), res.offsets.end(), res.offsets.begin());
+                res.indices.resize(res.offsets.back());
+            });
+            return res;
+        }
+
+        //------- OVERLAP JOINS -------
+
+        // Pairs (i, j) of this and other index whose k-sigma bands overlap
+        [[nodiscard]] std::vector<std::pair<std::size_t, std::size_t>> overlapJoin(const IntervalIndex &other, T k = 1,
+                                                                                 unsigned threads = 0) const {
+            return join(other, k, threads, false);
+        }
+
+        // Pairs (i, j) with i < j of this index whose k-sigma bands overlap
+        [[nodiscard]] std::vector<std::pair<std::size_t, std::size_t>> overlapJoin(T k = 1, unsigned threads = 0) const {
+            return join(*this, k, threads, true);
+        }
+
+        //------- NON-VOID METHODS -------
+
+        [[nodiscard]] std::size_t size() const {
+            return value.size();
+        }
+
+        [[nodiscard]] bool empty() const {
+            return value.empty();
+        }
+
+    protected:
+
+        // Sorted by value, index maps back to the ErrorArray the index was built from
+        std::vector<T> value;
+        std::vector<T> error;
+        std::vector<std::size_t> index;
+        // maxError[0] holds the largest error of every block, maxError[l + 1][i] of maxError[l][2i] and [2i + 1]
+        std::vector<std::vector<T>> maxError;
+
+        static T reach(T e, T eq, T k, Band band) {
+            return band == Band::OVERLAP ? k*(e + eq) : k*std::sqrt(e*e + eq*eq);
+        }
+
+        // Calls f(sorted position) for every match of query q with error eq
+        template <typename F>
+        void visit(T q, T eq, T k, Band band, F &&f) const {
+            if (!maxError.empty())
+                visitNode(maxError.size() - 1, 0, q, eq, k, band, f);
+        }
+
+        template <typename F>
+        void visitNode(std::size_t level, std::size_t node, T q, T eq, T k, Band band, F &f) const {
+            const std::size_t blocks = maxError[0].size();
+            const std::size_t firstBlock = node << level;
+            if (firstBlock >= blocks)
+                return;
+            const std::size_t first = firstBlock*BLOCK;
+            const std::size_t last = std::min(std::min((node + 1) << level, blocks)*BLOCK, size()) - 1;
+            const T r = reach(maxError[level][node], eq, k, band);
+            if (q + r < value[first] || q - r > value[last])
+                return;
+            if (level > 0) {
+                visitNode(level - 1, 2*node, q, eq, k, band, f);
+                visitNode(level - 1, 2*node + 1, q, eq, k, band, f);
+                return;
+            }
+            for (std::size_t i = first; i <= last; ++i)
+                if (std::abs(value[i] - q) <= reach(error[i], eq, k, band))
+                    f(i);
+        }
+
+        // Splits n sorted queries into one part per thread: collect(first, last, found) runs per part, then
+        // prepare() once, then scatter(first, last, found) per part
+        template <typename Collect, typename Scatter, typename Prepare>
+        static void forParts(std::size_t n, unsigned threads, Collect collect, Scatter scatter, Prepare prepare) {
+            const std::size_t parts = std::max<std::size_t>(1, std::min<std::size_t>(parallel::threadCount(threads),
+                                                                                     n/MIN_QUERIES_PER_THREAD));
+            std::vector<std::vector<std::size_t>> found(parts);
+            parallel::forRanges(parts, threads, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t p = begin; p < end; ++p)
+                    collect(n*p/parts, n*(p + 1)/parts, found[p]);
+            });
+            prepare();
+            parallel::forRanges(parts, threads, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t p = begin; p < end; ++p)
+                    scatter(n*p/parts, n*(p + 1)/parts, found[p]);
+            });
+        }
+
+        // Every element of other, in its sorted order, is a query against this index
+        std::vector<std::pair<std::size_t, std::size_t>> join(const IntervalIndex &other, T k, unsigned threads,
+                                                              bool self) const {
+            using Pair = std::pair<std::size_t, std::size_t>;
+            const std::size_t n = other.size();
+            const std::size_t parts = std::max<std::size_t>(1, std::min<std::size_t>(parallel::threadCount(threads),
+                                                                                     n/MIN_QUERIES_PER_THREAD));
+            std::vector<std::vector<Pair>> found(parts);
+            parallel::forRanges(parts, threads, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t p = begin; p < end; ++p)
+                    for (std::size_t s = n*p/parts; s < n*(p + 1)/parts; ++s)
+                        visit(other.value[s], other.error[s], k, Band::OVERLAP, [&](std::size_t i) {
+                            if (!self)
+                                found[p].emplace_back(index[i], other.index[s]);
+                            else if (i > s)
+                                found[p].emplace_back(std::min(index[i], index[s]), std::max(index[i], index[s]));
+                        });
+            });
+            std::vector<Pair> res;
+            for (const std::vector<Pair> &f : found)
+                res.insert(res.end(), f.begin(), f.end());
+            return res;
+        }
+
+    };
+
+}
+
+#endif //LIBERRC_ERRC_INTERVAL_H
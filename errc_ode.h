@@ -0,0 +1,475 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_ODE_H
+#define LIBERRC_ERRC_ODE_H
+
+// Runge-Kutta integration of dy/dt = f(t, y, p) with uncertain initial state y0 and parameters p. The state is
+// integrated in Dual<T, N + P> arithmetic, which integrates the sensitivity equations dS/dt = df/dy*S + df/dp
+// with the same Runge-Kutta scheme as the state. The covariance of y(t) is S*C*S^T, where C is the joint
+// covariance of (y0, p), so correlations between state components come out right.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "errc_covariance.h"
+#include "errc_dual.h"
+#include "errc_parallel.h"
+#include "errc_simd.h"
+
+namespace liberrc::ode {
+
+    //------- METHODS -------
+
+    // Classic fourth order Runge-Kutta
+    template <typename T>
+    struct RK4 {
+        static constexpr bool EMBEDDED = false;
+        static constexpr std::size_t STAGES = 4;
+        static constexpr T c[STAGES] = {0, T(1)/2, T(1)/2, 1};
+        static constexpr T a[STAGES][STAGES] = {{}, {T(1)/2}, {0, T(1)/2}, {0, 0, 1}};
+        static constexpr T b[STAGES] = {T(1)/6, T(1)/3, T(1)/3, T(1)/6};
+    };
+
+    // Dormand-Prince 5(4): b is the fifth order solution, e = b - b* estimates the local error
+    template <typename T>
+    struct DormandPrince {
+        static constexpr bool EMBEDDED = true;
+        static constexpr std::size_t STAGES = 7;
+        static constexpr T c[STAGES] = {0, T(1)/5, T(3)/10, T(4)/5, T(8)/9, 1, 1};
+        static constexpr T a[STAGES][STAGES] = {
+                {},
+                {T(1)/5},
+                {T(3)/40, T(9)/40},
+                {T(44)/45, T(-56)/15, T(32)/9},
+                {T(19372)/6561, T(-25360)/2187, T(64448)/6561, T(-212)/729},
+                {T(9017)/3168, T(-355)/33, T(46732)/5247, T(49)/176, T(-5103)/18656},
+                {T(35)/384, 0, T(500)/1113, T(125)/192, T(-2187)/6784, T(11)/84}
+        };
+        static constexpr T b[STAGES] = {T(35)/384, 0, T(500)/1113, T(125)/192, T(-2187)/6784, T(11)/84, 0};
+        static constexpr T e[STAGES] = {
+                T(35)/384 - T(5179)/57600, 0, T(500)/1113 - T(7571)/16695, T(125)/192 - T(393)/640,
+                T(-2187)/6784 + T(92097)/339200, T(11)/84 - T(187)/2100, T(-1)/40
+        };
+    };
+
+    template <typename T>
+    struct Options {
+        T relativeTolerance = T(1e-6);
+        T absoluteTolerance = T(1e-9);
+        // 0 starts with (t1 - t0)/100
+        T initialStep = 0;
+        std::size_t maxSteps = 100000;
+        // Batched integration only, 0 uses every hardware thread
+        unsigned threads = 0;
+    };
+
+    //------- HELPERS -------
+
+    // Joint covariance of independent y0 and p
+    template <typename T, std::size_t N, std::size_t P>
+    ErrorVector<T, N + P> joint(const ErrorVector<T, N> &y0, const ErrorVector<T, P> &p) {
+        ErrorVector<T, N + P> res;
+        for (std::size_t i = 0; i < N; ++i) {
+            res.value[i] = y0.value[i];
+            for (std::size_t j = 0; j < N; ++j)
+                res.covariance[i][j] = y0.covariance[i][j];
+        }
+        for (std::size_t i = 0; i < P; ++i) {
+            res.value[N + i] = p.value[i];
+            for (std::size_t j = 0; j < P; ++j)
+                res.covariance[N + i][N + j] = p.covariance[i][j];
+        }
+        return res;
+    }
+
+    template <typename T>
+    void checkInterval(T t0, T t1) {
+        if (!(t1 >= t0))
+            throw std::invalid_argument("Integration interval must not be reversed: from " + std::to_string(t0) +
+                                        " to " + std::to_string(t1));
+    }
+
+    // Step size after a step with error norm (accepted if norm <= 1)
+    template <typename T>
+    T nextStep(T h, T norm) {
+        T factor = norm == 0 ? T(5) : T(0.9)*std::pow(norm, T(-0.2));
+        return h*std::clamp(factor, T(0.2), T(5));
+    }
+
+    template <typename T>
+    T errorScale(const Options<T> &options, T y, T next) {
+        return options.absoluteTolerance + options.relativeTolerance*std::max(std::abs(y), std::abs(next));
+    }
+
+    // Advances t by h, landing exactly on t1 for the last step
+    template <typename T>
+    T advance(T t, T h, T t1) {
+        return h >= t1 - t ? t1 : t + h;
+    }
+
+    //------- SCALAR INTEGRATION -------
+
+    template <typename T, std::size_t N, std::size_t K>
+    using State = std::array<Dual<T, K>, N>;
+
+    // One Runge-Kutta step, writes the error estimate of embedded methods into err
+    template <typename Method, typename F, typename T, std::size_t N, std::size_t K, std::size_t P>
+    State<T, N, K> step(F &f, T t, const State<T, N, K> &y, const std::array<Dual<T, K>, P> &p, T h,
+                        State<T, N, K> *err = nullptr) {
+        std::array<State<T, N, K>, Method::STAGES> k;
+        for (std::size_t s = 0; s < Method::STAGES; ++s) {
+            State<T, N, K> ys = y;
+            for (std::size_t j = 0; j < s; ++j)
+                if (Method::a[s][j] != 0)
+                    for (std::size_t n = 0; n < N; ++n)
+                        ys[n] += k[j][n]*(h*Method::a[s][j]);
+            const auto r = f(t + Method::c[s]*h, ys, p);
+            for (std::size_t n = 0; n < N; ++n)
+                k[s][n] = r[n];
+        }
+        State<T, N, K> res = y;
+        for (std::size_t s = 0; s < Method::STAGES; ++s)
+            for (std::size_t n = 0; n < N; ++n)
+                res[n] += k[s][n]*(h*Method::b[s]);
+        if constexpr (Method::EMBEDDED) {
+            if (err != nullptr)
+                for (std::size_t n = 0; n < N; ++n) {
+                    (*err)[n] = Dual<T, K>();
+                    for (std::size_t s = 0; s < Method::STAGES; ++s)
+                        (*err)[n] += k[s][n]*(h*Method::e[s]);
+                }
+        }
+        return res;
+    }
+
+    template <typename T, std::size_t N, std::size_t K>
+    T errorNorm(const Options<T> &options, const State<T, N, K> &y, const State<T, N, K> &next,
+                const State<T, N, K> &err) {
+        T norm = 0;
+        for (std::size_t n = 0; n < N; ++n)
+            norm = std::max(norm, std::abs(err[n].value)/errorScale(options, y[n].value, next[n].value));
+        return norm;
+    }
+
+    // Seeds y0 as variables 0..N-1 and p as variables N..N+P-1
+    template <typename T, std::size_t N, std::size_t P>
+    void seed(const ErrorVector<T, N + P> &x, State<T, N, N + P> &y, std::array<Dual<T, N + P>, P> &p) {
+        for (std::size_t i = 0; i < N; ++i)
+            y[i] = Dual<T, N + P>(x.value[i], i);
+        for (std::size_t i = 0; i < P; ++i)
+            p[i] = Dual<T, N + P>(x.value[N + i], N + i);
+    }
+
+    template <typename T, std::size_t N, std::size_t K>
+    ErrorVector<T, N> result(const State<T, N, K> &y, const ErrorVector<T, K> &x) {
+        ErrorVector<T, N> res;
+        Matrix<T, N, K> s;
+        for (std::size_t n = 0; n < N; ++n) {
+            res.value[n] = y[n].value;
+            s[n] = y[n].grad;
+        }
+        res.covariance = covariance::sandwich(s, x.covariance);
+        return res;
+    }
+
+    // f(t, y, p) takes std::array<Dual<T, N + P>, N> and std::array<Dual<T, N + P>, P> and returns N derivatives
+    template <typename F, typename T, std::size_t N, std::size_t P>
+    ErrorVector<T, N> rk4(F &&f, T t0, T t1, std::size_t steps, const ErrorVector<T, N> &y0,
+                          const ErrorVector<T, P> &p) {
+        checkInterval(t0, t1);
+        ErrorVector<T, N + P> x = joint(y0, p);
+        State<T, N, N + P> y;
+        std::array<Dual<T, N + P>, P> pd;
+        seed(x, y, pd);
+        T h = (t1 - t0)/static_cast<T>(std::max<std::size_t>(steps, 1));
+        for (std::size_t i = 0; i < steps; ++i)
+            y = step<RK4<T>>(f, t0 + h*static_cast<T>(i), y, pd, h);
+        return result(y, x);
+    }
+
+    template <typename F, typename T, std::size_t N>
+    ErrorVector<T, N> rk4(F &&f, T t0, T t1, std::size_t steps, const ErrorVector<T, N> &y0) {
+        return rk4(f, t0, t1, steps, y0, ErrorVector<T, 0>());
+    }
+
+    // Adaptive Dormand-Prince integration, the step size is controlled by the error of the values only
+    template <typename F, typename T, std::size_t N, std::size_t P>
+    ErrorVector<T, N> rk45(F &&f, T t0, T t1, const ErrorVector<T, N> &y0, const ErrorVector<T, P> &p,
+                           const Options<T> &options = Options<T>()) {
+        checkInterval(t0, t1);
+        ErrorVector<T, N + P> x = joint(y0, p);
+        State<T, N, N + P> y, err;
+        std::array<Dual<T, N + P>, P> pd;
+        seed(x, y, pd);
+
+        T t = t0;
+        T h = options.initialStep > 0 ? options.initialStep : (t1 - t0)/100;
+        for (std::size_t steps = 0; t < t1; ++steps) {
+            if (steps == options.maxSteps)
+                throw std::runtime_error("rk45 did not reach t1 in " + std::to_string(options.maxSteps) + " steps");
+            h = std::min(h, t1 - t);
+            State<T, N, N + P> next = step<DormandPrince<T>>(f, t, y, pd, h, &err);
+            T norm = errorNorm(options, y, next, err);
+            if (norm <= 1) {
+                t = advance(t, h, t1);
+                y = next;
+            }
+            h = nextStep(h, norm);
+        }
+        return result(y, x);
+    }
+
+    template <typename F, typename T, std::size_t N>
+    ErrorVector<T, N> rk45(F &&f, T t0, T t1, const ErrorVector<T, N> &y0, const Options<T> &options = Options<T>()) {
+        return rk45(f, t0, t1, y0, ErrorVector<T, 0>(), options);
+    }
+
+    //------- BATCH KERNELS -------
+
+    // out = y + sum(w[s]*k[s]) over n elements
+    template <typename T>
+    using CombineKernel = void (*)(T*, const T*, const T* const*, const T*, std::size_t, std::size_t);
+
+    template <typename T>
+    struct Kernels {
+        simd::Isa isa;
+        CombineKernel<T> combine;
+    };
+
+}
+
+#define LIBERRC_KERNELS_FILE "errc_ode_kernels.inl"
+#include "errc_foreach_isa.h"
+
+namespace liberrc::ode {
+
+    template <typename T>
+    const Kernels<T>& kernels(simd::Isa isa) {
+        return simd::onIsa(isa, [](auto target) -> const Kernels<T>& {
+            return odeKernels(target, static_cast<T*>(nullptr));
+        });
+    }
+
+    template <typename T>
+    const Kernels<T>& kernels() {
+        static const Kernels<T> &bound = kernels<T>(simd::activeIsa());
+        return bound;
+    }
+
+    //------- BATCH INTEGRATION -------
+
+    // Trajectories of one ErrorVectorArray block advancing together. Every state component n has K + 1 planes of
+    // BLOCK lanes: the value and its derivatives by the K inputs, stage sums run over all planes at once.
+    template <typename T, std::size_t N, std::size_t P>
+    class Block {
+
+    public:
+
+        static constexpr std::size_t K = N + P;
+        static constexpr std::size_t B = ErrorVectorArray<T, K>::BLOCK;
+        static constexpr std::size_t SIZE = N*(K + 1)*B;
+
+        Block(const Kernels<T> &kernels_, const T* in_, std::size_t lanes_)
+                : kernels(kernels_), in(in_), lanes(lanes_) {
+            for (std::size_t l = 0; l < lanes; ++l) {
+                std::array<T, K> x;
+                for (std::size_t i = 0; i < K; ++i)
+                    x[i] = in[i*B + l];
+                State<T, N, K> s;
+                std::array<Dual<T, K>, P> ignored;
+                seed(ErrorVector<T, K>(x, {}), s, ignored);
+                scatter(s, y.data(), l);
+            }
+        }
+
+        template <typename Method, typename F>
+        void step(F &f, T t, T h) {
+            std::array<const T*, Method::STAGES> kp;
+            std::array<T, Method::STAGES> w;
+            for (std::size_t s = 0; s < Method::STAGES; ++s) {
+                kp[s] = k.data() + s*SIZE;
+                for (std::size_t j = 0; j < s; ++j)
+                    w[j] = h*Method::a[s][j];
+                kernels.combine(ys.data(), y.data(), kp.data(), w.data(), s, SIZE);
+                evaluate(f, t + Method::c[s]*h, k.data() + s*SIZE);
+            }
+            for (std::size_t s = 0; s < Method::STAGES; ++s)
+                w[s] = h*Method::b[s];
+            kernels.combine(next.data(), y.data(), kp.data(), w.data(), Method::STAGES, SIZE);
+        }
+
+        // Largest error norm of the last Dormand-Prince step over the lanes of this block
+        T errorNorm(const Options<T> &options, T h) const {
+            T norm = 0;
+            for (std::size_t n = 0; n < N; ++n) {
+                const std::size_t v = n*(K + 1)*B;
+                for (std::size_t l = 0; l < lanes; ++l) {
+                    T err = 0;
+                    for (std::size_t s = 0; s < DormandPrince<T>::STAGES; ++s)
+                        err += h*DormandPrince<T>::e[s]*k[s*SIZE + v + l];
+                    norm = std::max(norm, std::abs(err)/errorScale(options, y[v + l], next[v + l]));
+                }
+            }
+            return norm;
+        }
+
+        void accept() {
+            y.swap(next);
+        }
+
+        // Writes means and S*C*S^T into an ErrorVectorArray<T, N> block
+        void store(const batch::CovarianceKernels<T> &sandwich, T* out) const {
+            std::vector<T> jac(N*K*B);
+            for (std::size_t n = 0; n < N; ++n) {
+                for (std::size_t l = 0; l < B; ++l)
+                    out[n*B + l] = y[n*(K + 1)*B + l];
+                for (std::size_t i = 0; i < K; ++i)
+                    std::copy_n(y.data() + (n*(K + 1) + 1 + i)*B, B, jac.data() + (n*K + i)*B);
+            }
+            sandwich.sandwich(jac.data(), in, out, 1);
+        }
+
+    protected:
+
+        const Kernels<T> &kernels;
+        const T* in;
+        std::size_t lanes;
+        std::vector<T> y = std::vector<T>(SIZE), ys = std::vector<T>(SIZE), next = std::vector<T>(SIZE);
+        std::vector<T> k = std::vector<T>(DormandPrince<T>::STAGES*SIZE);
+
+        static void scatter(const State<T, N, K> &s, T* planes, std::size_t lane) {
+            for (std::size_t n = 0; n < N; ++n) {
+                planes[n*(K + 1)*B + lane] = s[n].value;
+                for (std::size_t i = 0; i < K; ++i)
+                    planes[(n*(K + 1) + 1 + i)*B + lane] = s[n].grad[i];
+            }
+        }
+
+        // Derivatives of the ys lanes into planes, lanes past the end of the array stay zero
+        template <typename F>
+        void evaluate(F &f, T t, T* planes) const {
+            for (std::size_t l = 0; l < lanes; ++l) {
+                State<T, N, K> s;
+                std::array<Dual<T, K>, P> p;
+                for (std::size_t n = 0; n < N; ++n) {
+                    s[n].value = ys[n*(K + 1)*B + l];
+                    for (std::size_t i = 0; i < K; ++i)
+                        s[n].grad[i] = ys[(n*(K + 1) + 1 + i)*B + l];
+                }
+                for (std::size_t i = 0; i < P; ++i)
+                    p[i] = Dual<T, K>(in[(N + i)*B + l], N + i);
+                const auto r = f(t, s, p);
+                State<T, N, K> d;
+                for (std::size_t n = 0; n < N; ++n)
+                    d[n] = r[n];
+                scatter(d, planes, l);
+            }
+        }
+
+    };
+
+    template <typename T, std::size_t N, std::size_t P>
+    ErrorVectorArray<T, N + P> joint(const ErrorVectorArray<T, N> &y0, const ErrorVectorArray<T, P> &p) {
+        if (P != 0 && y0.size() != p.size())
+            throw std::invalid_argument("ErrorVectorArray sizes must match: " + std::to_string(y0.size()) +
+                                        " and " + std::to_string(p.size()));
+        ErrorVectorArray<T, N + P> res(y0.size());
+        for (std::size_t i = 0; i < y0.size(); ++i)
+            res.set(i, joint(y0[i], P != 0 ? p[i] : ErrorVector<T, P>()));
+        return res;
+    }
+
+    // Runs integrate(block) for every block of y0 on options.threads threads
+    template <typename T, std::size_t N, std::size_t P, typename I>
+    ErrorVectorArray<T, N> integrateBlocks(const ErrorVectorArray<T, N> &y0, const ErrorVectorArray<T, P> &p,
+                                           unsigned threads, const Kernels<T> &kernels, I integrate) {
+        constexpr std::size_t B = ErrorVectorArray<T, N>::BLOCK;
+        const ErrorVectorArray<T, N + P> x = joint(y0, p);
+        const batch::CovarianceKernels<T> &sandwich = batch::covarianceKernels<T, N + P, N>();
+        ErrorVectorArray<T, N> res(y0.size());
+        parallel::forRanges(x.blocks(), threads, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t b = begin; b < end; ++b) {
+                Block<T, N, P> block(kernels, x.raw() + b*ErrorVectorArray<T, N + P>::PLANES*B,
+                                     std::min(B, x.size() - b*B));
+                integrate(block);
+                block.store(sandwich, res.raw() + b*ErrorVectorArray<T, N>::PLANES*B);
+            }
+        });
+        return res;
+    }
+
+    // Batched rk4, trajectories i use y0[i] and p[i]
+    template <typename F, typename T, std::size_t N, std::size_t P>
+    ErrorVectorArray<T, N> rk4(F &&f, T t0, T t1, std::size_t steps, const ErrorVectorArray<T, N> &y0,
+                               const ErrorVectorArray<T, P> &p, unsigned threads = 0,
+                               const Kernels<T> &kernels = ode::kernels<T>()) {
+        checkInterval(t0, t1);
+        T h = (t1 - t0)/static_cast<T>(std::max<std::size_t>(steps, 1));
+        return integrateBlocks(y0, p, threads, kernels, [&](Block<T, N, P> &block) {
+            for (std::size_t i = 0; i < steps; ++i) {
+                block.template step<RK4<T>>(f, t0 + h*static_cast<T>(i), h);
+                block.accept();
+            }
+        });
+    }
+
+    template <typename F, typename T, std::size_t N>
+    ErrorVectorArray<T, N> rk4(F &&f, T t0, T t1, std::size_t steps, const ErrorVectorArray<T, N> &y0,
+                               unsigned threads = 0) {
+        return rk4(f, t0, t1, steps, y0, ErrorVectorArray<T, 0>(), threads);
+    }
+
+    // Batched rk45. The trajectories of a block share their step size, which is controlled by the largest error.
+    template <typename F, typename T, std::size_t N, std::size_t P>
+    ErrorVectorArray<T, N> rk45(F &&f, T t0, T t1, const ErrorVectorArray<T, N> &y0, const ErrorVectorArray<T, P> &p,
+                                const Options<T> &options = Options<T>(),
+                                const Kernels<T> &kernels = ode::kernels<T>()) {
+        checkInterval(t0, t1);
+        return integrateBlocks(y0, p, options.threads, kernels, [&](Block<T, N, P> &block) {
+            T t = t0;
+            T h = options.initialStep > 0 ? options.initialStep : (t1 - t0)/100;
+            for (std::size_t steps = 0; t < t1; ++steps) {
+                if (steps == options.maxSteps)
+                    throw std::runtime_error("rk45 did not reach t1 in " + std::to_string(options.maxSteps) +
+                                             " steps");
+                h = std::min(h, t1 - t);
+                block.template step<DormandPrince<T>>(f, t, h);
+                T norm = block.errorNorm(options, h);
+                if (norm <= 1) {
+                    t = advance(t, h, t1);
+                    block.accept();
+                }
+                h = nextStep(h, norm);
+            }
+        });
+    }
+
+    template <typename F, typename T, std::size_t N>
+    ErrorVectorArray<T, N> rk45(F &&f, T t0, T t1, const ErrorVectorArray<T, N> &y0,
+                                const Options<T> &options = Options<T>()) {
+        return rk45(f, t0, t1, y0, ErrorVectorArray<T, 0>(), options);
+    }
+
+}
+
+#endif //LIBERRC_ERRC_ODE_H
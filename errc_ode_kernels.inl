@@ -0,0 +1,37 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+// Runge-Kutta stage combinations over the planes of a block of trajectories, included by errc_foreach_isa.h.
+// n is a multiple of BLOCK, so there is no scalar tail.
+
+template <typename T>
+void combineKernel(T* out, const T* y, const T* const* k, const T* w, std::size_t stages, std::size_t n) {
+    for (std::size_t i = 0; i < n; i += Pack<T>::width) {
+        Pack<T> acc = Pack<T>::load(y + i);
+        for (std::size_t s = 0; s < stages; ++s)
+            if (w[s] != 0)
+                acc = fma(Pack<T>::broadcast(w[s]), Pack<T>::load(k[s] + i), acc);
+        acc.store(out + i);
+    }
+}
+
+template <typename T>
+const ode::Kernels<T>& odeKernels(Target, T*) {
+    static constexpr ode::Kernels<T> table = {TARGET_ISA, &combineKernel<T>};
+    return table;
+}
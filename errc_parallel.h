@@ -0,0 +1,104 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_PARALLEL_H
+#define LIBERRC_ERRC_PARALLEL_H
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace liberrc::parallel {
+
+    // 0 means one thread per hardware thread
+    inline unsigned threadCount(unsigned requested) {
+        if (requested != 0)
+            return requested;
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Calls body(begin, end) for contiguous ranges covering [0, n), one range per thread. The calling thread
+    // waits for all of them and rethrows the first exception thrown by body.
+    template <typename F>
+    void forRanges(std::size_t n, unsigned threads, F body) {
+        std::size_t count = std::min<std::size_t>(threadCount(threads), n);
+        if (count <= 1) {
+            if (n != 0)
+                body(std::size_t(0), n);
+            return;
+        }
+
+        std::vector<std::exception_ptr> errors(count);
+        std::vector<std::thread> pool;
+        pool.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+            pool.emplace_back([&body, &errors, i, begin = n*i/count, end = n*(i + 1)/count]() {
+                try {
+                    body(begin, end);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        for (std::thread &t : pool)
+            t.join();
+        for (const std::exception_ptr &e : errors)
+            if (e)
+                std::rethrow_exception(e);
+    }
+
+    // Smallest number of elements per thread worth sorting separately
+    constexpr std::size_t MIN_SORT_PER_THREAD = 1 << 14;
+
+    // Sorts chunks on separate threads, then merges pairs of sorted runs in parallel rounds
+    template <typename V, typename Compare = std::less<V>>
+    void sort(std::vector<V> &v, Compare comp = Compare(), unsigned threads = 0) {
+        const std::size_t n = v.size();
+        const std::size_t parts = std::min<std::size_t>(threadCount(threads), n/MIN_SORT_PER_THREAD);
+        if (parts <= 1) {
+            std::sort(v.begin(), v.end(), comp);
+            return;
+        }
+
+        std::vector<std::size_t> bounds(parts + 1);
+        for (std::size_t p = 0; p <= parts; ++p)
+            bounds[p] = n*p/parts;
+        forRanges(parts, threads, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t p = begin; p < end; ++p)
+                std::sort(v.begin() + bounds[p], v.begin() + bounds[p + 1], comp);
+        });
+
+        std::vector<V> buffer(n);
+        for (std::size_t width = 1; width < parts; width *= 2) {
+            forRanges((parts + 2*width - 1)/(2*width), threads, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t m = begin; m < end; ++m) {
+                    std::size_t first = bounds[2*width*m];
+                    std::size_t mid = bounds[std::min(2*width*m + width, parts)];
+                    std::size_t last = bounds[std::min(2*width*(m + 1), parts)];
+                    std::merge(v.begin() + first, v.begin() + mid, v.begin() + mid, v.begin() + last,
+                               buffer.begin() + first, comp);
+                }
+            });
+            v.swap(buffer);
+        }
+    }
+
+}
+
+#endif //LIBERRC_ERRC_PARALLEL_H
@@ -0,0 +1,209 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_POLY_H
+#define LIBERRC_ERRC_POLY_H
+
+// Polynomials c[0] + c[1]*x + ... + c[n-1]*x^(n-1) and rational functions p(x)/q(x) with uncertain coefficients,
+// evaluated by Horner's scheme in one pass. x enters once through the derivative, so its error is not counted once
+// per power as in chained ErrorValue arithmetic:
+//     e^2 = (p'(x)*ex)^2 + sum(ec[k]^2*x^(2k))
+// for independent coefficients. Coefficients are in increasing powers, as in fit::Result.
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "errc.h"
+#include "errc_batch.h"
+#include "errc_simd.h"
+
+namespace liberrc::poly {
+
+    // Evaluates a polynomial with terms coefficients at n points
+    template <typename T>
+    using PolyvalKernel = void (*)(const T*, const T*, std::size_t, const T*, const T*, T*, T*, std::size_t);
+
+    // Evaluates the quotient of two polynomials at n points
+    template <typename T>
+    using RatvalKernel = void (*)(const T*, const T*, std::size_t, const T*, const T*, std::size_t,
+                                  const T*, const T*, T*, T*, std::size_t);
+
+    template <typename T>
+    struct Kernels {
+        simd::Isa isa;
+        PolyvalKernel<T> polyval;
+        RatvalKernel<T> ratval;
+    };
+
+}
+
+#define LIBERRC_KERNELS_FILE "errc_poly_kernels.inl"
+#include "errc_foreach_isa.h"
+
+namespace liberrc {
+
+    namespace poly {
+
+        //------- DISPATCH -------
+
+        template <typename T>
+        const Kernels<T>& kernels(simd::Isa isa) {
+            return simd::onIsa(isa, [](auto target) -> const Kernels<T>& {
+                return polyKernels(target, static_cast<T*>(nullptr));
+            });
+        }
+
+        template <typename T>
+        const Kernels<T>& kernels() {
+            static const Kernels<T> &bound = kernels<T>(simd::activeIsa());
+            return bound;
+        }
+
+        //------- HORNER -------
+
+        // a*b + c, fused where the target has a fast fma
+        template <typename T>
+        T multiplyAdd(T a, T b, T c) {
+#ifdef FP_FAST_FMA
+            if constexpr (std::is_same<T, double>::value)
+                return std::fma(a, b, c);
+#endif
+#ifdef FP_FAST_FMAF
+            if constexpr (std::is_same<T, float>::value)
+                return std::fma(a, b, c);
+#endif
+            return a*b + c;
+        }
+
+        template <typename T, typename E>
+        struct Horner {
+            T value = 0;
+            T derivative = 0;
+            // Variance contributed by the coefficients, sum(ec[k]^2*x^(2k))
+            E variance = 0;
+        };
+
+        // coefficient(k) returns the ErrorValue (or anything with value and error) of the k-th coefficient
+        template <typename T, typename E, typename Coefficient>
+        Horner<T, E> horner(std::size_t terms, T x, Coefficient coefficient) {
+            Horner<T, E> res;
+            const E x2 = static_cast<E>(x)*static_cast<E>(x);
+            for (std::size_t k = terms; k-- > 0;) {
+                const auto c = coefficient(k);
+                const E e = static_cast<E>(c.error);
+                res.derivative = multiplyAdd(res.derivative, x, res.value);
+                res.value = multiplyAdd(res.value, x, static_cast<T>(c.value));
+                res.variance = multiplyAdd(res.variance, x2, e*e);
+            }
+            return res;
+        }
+
+        template <typename T, typename E>
+        ErrorValue<T, E> polyval(const Horner<T, E> &p, E ex) {
+            const E dx = static_cast<E>(p.derivative)*ex;
+            return ErrorValue<T, E>(p.value, std::sqrt(multiplyAdd(dx, dx, p.variance)));
+        }
+
+        template <typename T, typename E>
+        ErrorValue<T, E> ratval(const Horner<T, E> &p, const Horner<T, E> &q, E ex) {
+            const T value = p.value/q.value;
+            // (p/q)' = (p' - r*q')/q, the coefficient variances scale with 1/q^2
+            const E dx = static_cast<E>((p.derivative - value*q.derivative)/q.value)*ex;
+            const E r = static_cast<E>(value), scale = static_cast<E>(q.value);
+            const E variance = multiplyAdd(r*r, q.variance, p.variance)/(scale*scale);
+            return ErrorValue<T, E>(value, std::sqrt(multiplyAdd(dx, dx, variance)));
+        }
+
+        inline void checkDenominator(std::size_t terms) {
+            if (terms == 0)
+                throw std::invalid_argument("Denominator of a rational function must have coefficients");
+        }
+
+        //------- RAW ARRAY FUNCTIONS -------
+
+        template <typename T>
+        void polyval(const T* cv, const T* ce, std::size_t terms, const T* xv, const T* xe, T* rv, T* re,
+                     std::size_t n) {
+            kernels<T>().polyval(cv, ce, terms, xv, xe, rv, re, n);
+        }
+
+        template <typename T>
+        void ratval(const T* pv, const T* pe, std::size_t pterms, const T* qv, const T* qe, std::size_t qterms,
+                    const T* xv, const T* xe, T* rv, T* re, std::size_t n) {
+            checkDenominator(qterms);
+            kernels<T>().ratval(pv, pe, pterms, qv, qe, qterms, xv, xe, rv, re, n);
+        }
+
+    }
+
+    //------- SCALAR EVALUATION -------
+
+    template <typename T, typename E>
+    ErrorValue<T, E> polyval(const std::vector<ErrorValue<T, E>> &c, const ErrorValue<T, E> &x) {
+        return poly::polyval(poly::horner<T, E>(c.size(), x.value, [&c](std::size_t k) -> const ErrorValue<T, E>& {
+            return c[k];
+        }), x.error);
+    }
+
+    template <typename T>
+    ErrorValue<T, T> polyval(const ErrorArray<T> &c, const ErrorValue<T, T> &x) {
+        return poly::polyval(poly::horner<T, T>(c.size(), x.value, [&c](std::size_t k) { return c[k]; }), x.error);
+    }
+
+    template <typename T, typename E>
+    ErrorValue<T, E> ratval(const std::vector<ErrorValue<T, E>> &p, const std::vector<ErrorValue<T, E>> &q,
+                            const ErrorValue<T, E> &x) {
+        poly::checkDenominator(q.size());
+        auto coefficients = [](const std::vector<ErrorValue<T, E>> &c) {
+            return [&c](std::size_t k) -> const ErrorValue<T, E>& { return c[k]; };
+        };
+        return poly::ratval(poly::horner<T, E>(p.size(), x.value, coefficients(p)),
+                            poly::horner<T, E>(q.size(), x.value, coefficients(q)), x.error);
+    }
+
+    template <typename T>
+    ErrorValue<T, T> ratval(const ErrorArray<T> &p, const ErrorArray<T> &q, const ErrorValue<T, T> &x) {
+        poly::checkDenominator(q.size());
+        return poly::ratval(poly::horner<T, T>(p.size(), x.value, [&p](std::size_t k) { return p[k]; }),
+                            poly::horner<T, T>(q.size(), x.value, [&q](std::size_t k) { return q[k]; }), x.error);
+    }
+
+    //------- BATCH EVALUATION -------
+
+    template <typename T>
+    ErrorArray<T> polyval(const ErrorArray<T> &c, const ErrorArray<T> &x) {
+        ErrorArray<T> res(x.size());
+        poly::polyval(c.value.data(), c.error.data(), c.size(), x.value.data(), x.error.data(),
+                      res.value.data(), res.error.data(), x.size());
+        return res;
+    }
+
+    template <typename T>
+    ErrorArray<T> ratval(const ErrorArray<T> &p, const ErrorArray<T> &q, const ErrorArray<T> &x) {
+        ErrorArray<T> res(x.size());
+        poly::ratval(p.value.data(), p.error.data(), p.size(), q.value.data(), q.error.data(), q.size(),
+                     x.value.data(), x.error.data(), res.value.data(), res.error.data(), x.size());
+        return res;
+    }
+
+}
+
+#endif //LIBERRC_ERRC_POLY_H
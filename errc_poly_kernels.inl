@@ -0,0 +1,122 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+// Polynomial kernels, included by errc_foreach_isa.h. Every lane runs Horner's scheme for its own x, U packs are
+// evaluated together so the value, derivative and variance chains of independent packs overlap in the pipeline.
+// Inputs of a block are loaded before its outputs are stored, so output arrays may alias x.
+
+//------- HELPERS -------
+
+constexpr std::size_t POLY_UNROLL = 2;
+
+template <typename P>
+struct HornerLanes {
+    P value;
+    P derivative;
+    P variance;
+};
+
+template <std::size_t U, typename P, typename T>
+inline void hornerLanes(const T* cv, const T* ce, std::size_t terms, const P* x, HornerLanes<P>* h) {
+    P x2[U];
+    for (std::size_t u = 0; u < U; ++u) {
+        x2[u] = x[u]*x[u];
+        h[u] = {P::zero(), P::zero(), P::zero()};
+    }
+    for (std::size_t k = terms; k-- > 0;) {
+        P c = P::broadcast(cv[k]), e = P::broadcast(ce[k]);
+        P e2 = e*e;
+        for (std::size_t u = 0; u < U; ++u) {
+            h[u].derivative = fma(h[u].derivative, x[u], h[u].value);
+            h[u].value = fma(h[u].value, x[u], c);
+            h[u].variance = fma(h[u].variance, x2[u], e2);
+        }
+    }
+}
+
+// Runs block<U, P>(i) over n elements: U packs at a time, then single packs, then scalars
+template <typename T, typename Block>
+inline void forEachPolyBlock(std::size_t n, Block block) {
+    using P = Pack<T>;
+    std::size_t i = 0;
+    for (; i + POLY_UNROLL*P::width <= n; i += POLY_UNROLL*P::width)
+        block(std::integral_constant<std::size_t, POLY_UNROLL>(), P(), i);
+    for (; i + P::width <= n; i += P::width)
+        block(std::integral_constant<std::size_t, 1>(), P(), i);
+    for (; i < n; ++i)
+        block(std::integral_constant<std::size_t, 1>(), scalar::Pack<T>(), i);
+}
+
+//------- KERNELS -------
+
+template <typename T>
+void polyvalKernel(const T* cv, const T* ce, std::size_t terms, const T* xv, const T* xe, T* rv, T* re,
+                   std::size_t n) {
+    forEachPolyBlock<T>(n, [=](auto unroll, auto p, std::size_t i) {
+        using P = decltype(p);
+        constexpr std::size_t U = decltype(unroll)::value;
+        P x[U], ex[U];
+        HornerLanes<P> h[U];
+        for (std::size_t u = 0; u < U; ++u) {
+            x[u] = P::load(xv + i + u*P::width);
+            ex[u] = P::load(xe + i + u*P::width);
+        }
+        hornerLanes<U>(cv, ce, terms, x, h);
+        for (std::size_t u = 0; u < U; ++u) {
+            P dx = h[u].derivative*ex[u];
+            h[u].value.store(rv + i + u*P::width);
+            sqrt(fma(dx, dx, h[u].variance)).store(re + i + u*P::width);
+        }
+    });
+}
+
+template <typename T>
+void ratvalKernel(const T* pv, const T* pe, std::size_t pterms, const T* qv, const T* qe, std::size_t qterms,
+                  const T* xv, const T* xe, T* rv, T* re, std::size_t n) {
+    forEachPolyBlock<T>(n, [=](auto unroll, auto p, std::size_t i) {
+        using P = decltype(p);
+        constexpr std::size_t U = decltype(unroll)::value;
+        P x[U], ex[U];
+        HornerLanes<P> hp[U], hq[U];
+        for (std::size_t u = 0; u < U; ++u) {
+            x[u] = P::load(xv + i + u*P::width);
+            ex[u] = P::load(xe + i + u*P::width);
+        }
+        hornerLanes<U>(pv, pe, pterms, x, hp);
+        hornerLanes<U>(qv, qe, qterms, x, hq);
+        for (std::size_t u = 0; u < U; ++u) {
+            P inverse = P::broadcast(1)/hq[u].value;
+            P r = hp[u].value*inverse;
+            P dx = (hp[u].derivative - r*hq[u].derivative)*inverse*ex[u];
+            P variance = fma(r*r, hq[u].variance, hp[u].variance)*inverse*inverse;
+            r.store(rv + i + u*P::width);
+            sqrt(fma(dx, dx, variance)).store(re + i + u*P::width);
+        }
+    });
+}
+
+//------- KERNEL TABLE -------
+
+template <typename T>
+const poly::Kernels<T>& polyKernels(Target, T*) {
+    static constexpr poly::Kernels<T> table = {
+            TARGET_ISA,
+            &polyvalKernel<T>, &ratvalKernel<T>
+    };
+    return table;
+}
@@ -0,0 +1,70 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_PROPAGATE_H
+#define LIBERRC_ERRC_PROPAGATE_H
+
+#include <array>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+#include "errc.h"
+#include "errc_dual.h"
+
+namespace liberrc {
+
+    namespace propagation {
+
+        // Dual type used for propagate: the widest error type of the inputs, one derivative per input
+        template <typename... E>
+        using DualFor = Dual<std::common_type_t<E...>, sizeof...(E)>;
+
+        template <typename D, typename F, typename... T, typename... E, std::size_t... I>
+        D evaluate(F &&f, std::index_sequence<I...>, const ErrorValue<T, E>&... x) {
+            return f(D(static_cast<typename D::value_type>(x.value), I)...);
+        }
+
+    }
+
+    // Evaluates f(x...) once in dual arithmetic and propagates the errors of independent x through all partial
+    // derivatives: error = sqrt(sum((df/dx_i*error_i)^2)). f must be callable with Dual<S, sizeof...(x)> arguments,
+    // a generic lambda using math functions unqualified (or after "using std::exp" etc.) works.
+    template <typename F, typename... T, typename... E>
+    auto propagate(F &&f, const ErrorValue<T, E>&... x) {
+        static_assert(sizeof...(x) > 0, "propagate needs at least one argument");
+        using D = propagation::DualFor<E...>;
+        using S = typename D::value_type;
+        const D r = propagation::evaluate<D>(f, std::index_sequence_for<T...>(), x...);
+
+        std::size_t i = 0;
+        S variance = 0;
+        auto add = [&](const auto &ev) {
+            S d = r.grad[i++]*static_cast<S>(ev.error);
+            variance += d*d;
+        };
+        (add(x), ...);
+
+        ErrorValue<S, S> res(r.value, std::sqrt(variance));
+        LIBERRC_TRACE_GRADIENT(PROPAGATE, res, r.grad, x...);
+        return res;
+    }
+
+}
+
+#endif //LIBERRC_ERRC_PROPAGATE_H
@@ -0,0 +1,473 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_SIMD_H
+#define LIBERRC_ERRC_SIMD_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#if !defined(LIBERRC_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define LIBERRC_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// Each ISA gets its own namespace with a Pack<T> type for float and double. Kernels are written once against
+// Pack<T> in an .inl file and compiled for every ISA by errc_foreach_isa.h, so a single binary carries all of them.
+
+namespace liberrc::simd {
+
+    enum class Isa {
+        SCALAR = 0,
+        SSE2 = 1,
+        AVX2 = 2,
+        AVX512 = 3
+    };
+
+    //------- ISA DETECTION -------
+
+    inline const char* isaName(Isa isa) {
+        switch (isa) {
+            case Isa::SSE2:
+                return "sse2";
+            case Isa::AVX2:
+                return "avx2";
+            case Isa::AVX512:
+                return "avx512";
+            default:
+                return "scalar";
+        }
+    }
+
+    inline bool parseIsa(const char* name, Isa &isa) {
+        for (Isa candidate : {Isa::SCALAR, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+            if (std::strcmp(name, isaName(candidate)) == 0) {
+                isa = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline Isa detectIsa() {
+#ifdef LIBERRC_SIMD_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return Isa::AVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return Isa::AVX2;
+        if (__builtin_cpu_supports("sse2"))
+            return Isa::SSE2;
+#endif
+        return Isa::SCALAR;
+    }
+
+    // Detected once per process. LIBERRC_FORCE_ISA=scalar|sse2|avx2|avx512 lowers the level for testing,
+    // a request above what the CPU supports is clamped to the best supported ISA.
+    inline Isa activeIsa() {
+        static const Isa isa = [] {
+            Isa best = detectIsa();
+            Isa forced;
+            const char* env = std::getenv("LIBERRC_FORCE_ISA");
+            if (env != nullptr && parseIsa(env, forced) && forced < best)
+                return forced;
+            return best;
+        }();
+        return isa;
+    }
+
+    //------- SCALAR -------
+
+    namespace scalar {
+
+        constexpr Isa TARGET_ISA = Isa::SCALAR;
+
+        struct Target {};
+
+        template <typename T>
+        struct Pack {
+            static constexpr std::size_t width = 1;
+            T r;
+
+            static Pack load(const T* p) { return {*p}; }
+            static Pack broadcast(T x) { return {x}; }
+            static Pack zero() { return {0}; }
+            void store(T* p) const { *p = r; }
+
+            Pack operator+(Pack b) const { return {r + b.r}; }
+            Pack operator-(Pack b) const { return {r - b.r}; }
+            Pack operator*(Pack b) const { return {r * b.r}; }
+            Pack operator/(Pack b) const { return {r / b.r}; }
+        };
+
+        template <typename T>
+        Pack<T> sqrt(Pack<T> a) { return {std::sqrt(a.r)}; }
+
+        template <typename T>
+        Pack<T> abs(Pack<T> a) { return {std::abs(a.r)}; }
+
+        template <typename T>
+        Pack<T> fma(Pack<T> a, Pack<T> b, Pack<T> c) { return {a.r*b.r + c.r}; }
+
+        template <typename T>
+        T hsum(Pack<T> a) { return a.r; }
+
+        // Bit k of the result is set if lane k of a is less (or equal) than lane k of b, NaN lanes compare false
+        template <typename T>
+        unsigned maskLess(Pack<T> a, Pack<T> b) { return a.r < b.r; }
+
+        template <typename T>
+        unsigned maskLessEqual(Pack<T> a, Pack<T> b) { return a.r <= b.r; }
+
+    }
+
+#ifdef LIBERRC_SIMD_X86
+
+    //------- SSE2 -------
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+    namespace sse2 {
+
+        constexpr Isa TARGET_ISA = Isa::SSE2;
+
+        struct Target {};
+
+        template <typename T>
+        struct Pack;
+
+        template <>
+        struct Pack<double> {
+            static constexpr std::size_t width = 2;
+            __m128d r;
+
+            static Pack load(const double* p) { return {_mm_loadu_pd(p)}; }
+            static Pack broadcast(double x) { return {_mm_set1_pd(x)}; }
+            static Pack zero() { return {_mm_setzero_pd()}; }
+            void store(double* p) const { _mm_storeu_pd(p, r); }
+
+            Pack operator+(Pack b) const { return {_mm_add_pd(r, b.r)}; }
+            Pack operator-(Pack b) const { return {_mm_sub_pd(r, b.r)}; }
+            Pack operator*(Pack b) const { return {_mm_mul_pd(r, b.r)}; }
+            Pack operator/(Pack b) const { return {_mm_div_pd(r, b.r)}; }
+        };
+
+        template <>
+        struct Pack<float> {
+            static constexpr std::size_t width = 4;
+            __m128 r;
+
+            static Pack load(const float* p) { return {_mm_loadu_ps(p)}; }
+            static Pack broadcast(float x) { return {_mm_set1_ps(x)}; }
+            static Pack zero() { return {_mm_setzero_ps()}; }
+            void store(float* p) const { _mm_storeu_ps(p, r); }
+
+            Pack operator+(Pack b) const { return {_mm_add_ps(r, b.r)}; }
+            Pack operator-(Pack b) const { return {_mm_sub_ps(r, b.r)}; }
+            Pack operator*(Pack b) const { return {_mm_mul_ps(r, b.r)}; }
+            Pack operator/(Pack b) const { return {_mm_div_ps(r, b.r)}; }
+        };
+
+        using scalar::sqrt;
+        using scalar::abs;
+        using scalar::fma;
+        using scalar::hsum;
+        using scalar::maskLess;
+        using scalar::maskLessEqual;
+
+        inline Pack<double> sqrt(Pack<double> a) { return {_mm_sqrt_pd(a.r)}; }
+        inline Pack<float> sqrt(Pack<float> a) { return {_mm_sqrt_ps(a.r)}; }
+
+        inline Pack<double> abs(Pack<double> a) { return {_mm_andnot_pd(_mm_set1_pd(-0.0), a.r)}; }
+        inline Pack<float> abs(Pack<float> a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.r)}; }
+
+        inline Pack<double> fma(Pack<double> a, Pack<double> b, Pack<double> c) { return a*b + c; }
+        inline Pack<float> fma(Pack<float> a, Pack<float> b, Pack<float> c) { return a*b + c; }
+
+        inline double hsum(Pack<double> a) {
+            return _mm_cvtsd_f64(_mm_add_sd(a.r, _mm_unpackhi_pd(a.r, a.r)));
+        }
+
+        inline float hsum(Pack<float> a) {
+            __m128 s = _mm_add_ps(a.r, _mm_movehl_ps(a.r, a.r));
+            return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+
+        inline unsigned maskLess(Pack<double> a, Pack<double> b) { return _mm_movemask_pd(_mm_cmplt_pd(a.r, b.r)); }
+        inline unsigned maskLess(Pack<float> a, Pack<float> b) { return _mm_movemask_ps(_mm_cmplt_ps(a.r, b.r)); }
+
+        inline unsigned maskLessEqual(Pack<double> a, Pack<double> b) {
+            return _mm_movemask_pd(_mm_cmple_pd(a.r, b.r));
+        }
+
+        inline unsigned maskLessEqual(Pack<float> a, Pack<float> b) {
+            return _mm_movemask_ps(_mm_cmple_ps(a.r, b.r));
+        }
+
+    }
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+    //------- AVX2 -------
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+    namespace avx2 {
+
+        constexpr Isa TARGET_ISA = Isa::AVX2;
+
+        struct Target {};
+
+        template <typename T>
+        struct Pack;
+
+        template <>
+        struct Pack<double> {
+            static constexpr std::size_t width = 4;
+            __m256d r;
+
+            static Pack load(const double* p) { return {_mm256_loadu_pd(p)}; }
+            static Pack broadcast(double x) { return {_mm256_set1_pd(x)}; }
+            static Pack zero() { return {_mm256_setzero_pd()}; }
+            void store(double* p) const { _mm256_storeu_pd(p, r); }
+
+            Pack operator+(Pack b) const { return {_mm256_add_pd(r, b.r)}; }
+            Pack operator-(Pack b) const { return {_mm256_sub_pd(r, b.r)}; }
+            Pack operator*(Pack b) const { return {_mm256_mul_pd(r, b.r)}; }
+            Pack operator/(Pack b) const { return {_mm256_div_pd(r, b.r)}; }
+        };
+
+        template <>
+        struct Pack<float> {
+            static constexpr std::size_t width = 8;
+            __m256 r;
+
+            static Pack load(const float* p) { return {_mm256_loadu_ps(p)}; }
+            static Pack broadcast(float x) { return {_mm256_set1_ps(x)}; }
+            static Pack zero() { return {_mm256_setzero_ps()}; }
+            void store(float* p) const { _mm256_storeu_ps(p, r); }
+
+            Pack operator+(Pack b) const { return {_mm256_add_ps(r, b.r)}; }
+            Pack operator-(Pack b) const { return {_mm256_sub_ps(r, b.r)}; }
+            Pack operator*(Pack b) const { return {_mm256_mul_ps(r, b.r)}; }
+            Pack operator/(Pack b) const { return {_mm256_div_ps(r, b.r)}; }
+        };
+
+        using scalar::sqrt;
+        using scalar::abs;
+        using scalar::fma;
+        using scalar::hsum;
+        using scalar::maskLess;
+        using scalar::maskLessEqual;
+
+        inline Pack<double> sqrt(Pack<double> a) { return {_mm256_sqrt_pd(a.r)}; }
+        inline Pack<float> sqrt(Pack<float> a) { return {_mm256_sqrt_ps(a.r)}; }
+
+        inline Pack<double> abs(Pack<double> a) { return {_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.r)}; }
+        inline Pack<float> abs(Pack<float> a) { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.r)}; }
+
+        inline Pack<double> fma(Pack<double> a, Pack<double> b, Pack<double> c) {
+            return {_mm256_fmadd_pd(a.r, b.r, c.r)};
+        }
+
+        inline Pack<float> fma(Pack<float> a, Pack<float> b, Pack<float> c) {
+            return {_mm256_fmadd_ps(a.r, b.r, c.r)};
+        }
+
+        inline double hsum(Pack<double> a) {
+            __m128d s = _mm_add_pd(_mm256_castpd256_pd128(a.r), _mm256_extractf128_pd(a.r, 1));
+            return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+        }
+
+        inline float hsum(Pack<float> a) {
+            __m128 s = _mm_add_ps(_mm256_castps256_ps128(a.r), _mm256_extractf128_ps(a.r, 1));
+            s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+            return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+
+        inline unsigned maskLess(Pack<double> a, Pack<double> b) {
+            return _mm256_movemask_pd(_mm256_cmp_pd(a.r, b.r, _CMP_LT_OQ));
+        }
+
+        inline unsigned maskLess(Pack<float> a, Pack<float> b) {
+            return _mm256_movemask_ps(_mm256_cmp_ps(a.r, b.r, _CMP_LT_OQ));
+        }
+
+        inline unsigned maskLessEqual(Pack<double> a, Pack<double> b) {
+            return _mm256_movemask_pd(_mm256_cmp_pd(a.r, b.r, _CMP_LE_OQ));
+        }
+
+        inline unsigned maskLessEqual(Pack<float> a, Pack<float> b) {
+            return _mm256_movemask_ps(_mm256_cmp_ps(a.r, b.r, _CMP_LE_OQ));
+        }
+
+    }
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+    //------- AVX-512 -------
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+
+    namespace avx512 {
+
+        constexpr Isa TARGET_ISA = Isa::AVX512;
+
+        struct Target {};
+
+        template <typename T>
+        struct Pack;
+
+        template <>
+        struct Pack<double> {
+            static constexpr std::size_t width = 8;
+            __m512d r;
+
+            static Pack load(const double* p) { return {_mm512_loadu_pd(p)}; }
+            static Pack broadcast(double x) { return {_mm512_set1_pd(x)}; }
+            static Pack zero() { return {_mm512_setzero_pd()}; }
+            void store(double* p) const { _mm512_storeu_pd(p, r); }
+
+            Pack operator+(Pack b) const { return {_mm512_add_pd(r, b.r)}; }
+            Pack operator-(Pack b) const { return {_mm512_sub_pd(r, b.r)}; }
+            Pack operator*(Pack b) const { return {_mm512_mul_pd(r, b.r)}; }
+            Pack operator/(Pack b) const { return {_mm512_div_pd(r, b.r)}; }
+        };
+
+        template <>
+        struct Pack<float> {
+            static constexpr std::size_t width = 16;
+            __m512 r;
+
+            static Pack load(const float* p) { return {_mm512_loadu_ps(p)}; }
+            static Pack broadcast(float x) { return {_mm512_set1_ps(x)}; }
+            static Pack zero() { return {_mm512_setzero_ps()}; }
+            void store(float* p) const { _mm512_storeu_ps(p, r); }
+
+            Pack operator+(Pack b) const { return {_mm512_add_ps(r, b.r)}; }
+            Pack operator-(Pack b) const { return {_mm512_sub_ps(r, b.r)}; }
+            Pack operator*(Pack b) const { return {_mm512_mul_ps(r, b.r)}; }
+            Pack operator/(Pack b) const { return {_mm512_div_ps(r, b.r)}; }
+        };
+
+        using scalar::sqrt;
+        using scalar::abs;
+        using scalar::fma;
+        using scalar::hsum;
+        using scalar::maskLess;
+        using scalar::maskLessEqual;
+
+        // The zero-masking forms avoid _mm512_undefined_*(), which GCC 12 reports as uninitialized under -Wall
+        inline Pack<double> sqrt(Pack<double> a) { return {_mm512_maskz_sqrt_pd(0xff, a.r)}; }
+        inline Pack<float> sqrt(Pack<float> a) { return {_mm512_maskz_sqrt_ps(0xffff, a.r)}; }
+
+        inline Pack<double> abs(Pack<double> a) { return {_mm512_abs_pd(a.r)}; }
+        inline Pack<float> abs(Pack<float> a) { return {_mm512_abs_ps(a.r)}; }
+
+        inline Pack<double> fma(Pack<double> a, Pack<double> b, Pack<double> c) {
+            return {_mm512_fmadd_pd(a.r, b.r, c.r)};
+        }
+
+        inline Pack<float> fma(Pack<float> a, Pack<float> b, Pack<float> c) {
+            return {_mm512_fmadd_ps(a.r, b.r, c.r)};
+        }
+
+        // Halves added explicitly with zero-masking extracts; _mm512_reduce_add_* and the 512-to-256 casts expand to
+        // extracts into _mm256_undefined_*() and warn like _mm512_sqrt_* does
+        inline double hsum(Pack<double> a) {
+            __m256d low = _mm512_maskz_extractf64x4_pd(0xf, a.r, 0), high = _mm512_maskz_extractf64x4_pd(0xf, a.r, 1);
+            return avx2::hsum(avx2::Pack<double>{_mm256_add_pd(low, high)});
+        }
+
+        inline float hsum(Pack<float> a) {
+            __m512d d = _mm512_castps_pd(a.r);
+            __m256 low = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xf, d, 0));
+            __m256 high = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xf, d, 1));
+            return avx2::hsum(avx2::Pack<float>{_mm256_add_ps(low, high)});
+        }
+
+        inline unsigned maskLess(Pack<double> a, Pack<double> b) { return _mm512_cmp_pd_mask(a.r, b.r, _CMP_LT_OQ); }
+        inline unsigned maskLess(Pack<float> a, Pack<float> b) { return _mm512_cmp_ps_mask(a.r, b.r, _CMP_LT_OQ); }
+
+        inline unsigned maskLessEqual(Pack<double> a, Pack<double> b) {
+            return _mm512_cmp_pd_mask(a.r, b.r, _CMP_LE_OQ);
+        }
+
+        inline unsigned maskLessEqual(Pack<float> a, Pack<float> b) {
+            return _mm512_cmp_ps_mask(a.r, b.r, _CMP_LE_OQ);
+        }
+
+    }
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif //LIBERRC_SIMD_X86
+
+    //------- DISPATCH -------
+
+    // Calls f with the Target tag of the given ISA. Kernel tables are looked up from the tag by ADL, so every
+    // feature that includes its kernels through errc_foreach_isa.h can bind them with a single generic lambda.
+    template <typename F>
+    decltype(auto) onIsa(Isa isa, F f) {
+        switch (isa) {
+#ifdef LIBERRC_SIMD_X86
+            case Isa::AVX512:
+                return f(avx512::Target());
+            case Isa::AVX2:
+                return f(avx2::Target());
+            case Isa::SSE2:
+                return f(sse2::Target());
+#endif
+            default:
+                return f(scalar::Target());
+        }
+    }
+
+}
+
+#endif //LIBERRC_ERRC_SIMD_H
@@ -0,0 +1,246 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_SOLVE_H
+#define LIBERRC_ERRC_SOLVE_H
+
+// Solvers for x with f(x, p...) = target, where target and p are ErrorValues. The root is found on plain values,
+// its error comes from implicit differentiation at the root: dx/dq = -(dF/dq)/(dF/dx) for F = f - target and
+// every q in (target, p...), so it costs one extra evaluation of f instead of a solve per perturbed input.
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "errc.h"
+#include "errc_batch.h"
+#include "errc_dual.h"
+#include "errc_parallel.h"
+
+namespace liberrc::solve {
+
+    template <typename T>
+    struct Options {
+        // Converged when the step is below tolerance*(1 + |x|)
+        T tolerance = 4*std::numeric_limits<T>::epsilon();
+        std::size_t maxIterations = 100;
+        // Batched solvers only, 0 uses every hardware thread
+        unsigned threads = 0;
+    };
+
+    //------- HELPERS -------
+
+    // f(x, p...) - target on plain values
+    template <typename S, typename F, typename... T, typename... E>
+    S residual(F &f, S x, S target, const ErrorValue<T, E>&... p) {
+        return static_cast<S>(f(x, static_cast<S>(p.value)...)) - target;
+    }
+
+    template <typename S, typename F, typename... T, typename... E, std::size_t... I>
+    Dual<S, 2 + sizeof...(T)> residualDual(F &f, S x, S target, std::index_sequence<I...>,
+                                           const ErrorValue<T, E>&... p) {
+        using D = Dual<S, 2 + sizeof...(T)>;
+        return f(D(x, 0), D(static_cast<S>(p.value), I + 2)...) - D(target, 1);
+    }
+
+    // Root with the error of (target, p...) propagated by implicit differentiation
+    template <typename S, typename F, typename TT, typename TE, typename... T, typename... E>
+    ErrorValue<S, S> implicit(F &f, S root, const ErrorValue<TT, TE> &target, const ErrorValue<T, E>&... p) {
+        const auto r = residualDual(f, root, static_cast<S>(target.value), std::index_sequence_for<T...>(), p...);
+        const S dx = r.grad[0];
+        if (dx == 0 || !std::isfinite(dx))
+            throw std::runtime_error("Root " + std::to_string(root) + " is not simple, its error is undefined");
+        const std::array<S, 1 + sizeof...(T)> errors = {static_cast<S>(target.error), static_cast<S>(p.error)...};
+        S variance = 0;
+        for (std::size_t i = 0; i < errors.size(); ++i) {
+            S d = r.grad[i + 1]/dx*errors[i];
+            variance += d*d;
+        }
+        return ErrorValue<S, S>(root, std::sqrt(variance));
+    }
+
+    template <typename S>
+    bool converged(const Options<S> &options, S step, S x) {
+        return std::abs(step) <= options.tolerance*(1 + std::abs(x));
+    }
+
+    //------- NEWTON -------
+
+    // Newton iteration from x0 for f(x, p...) = target
+    template <typename F, typename X, typename TT, typename TE, typename... T, typename... E,
+              typename S = std::common_type_t<X, TE, E...>>
+    ErrorValue<S, S> newton(F &&f, const ErrorValue<TT, TE> &target, X x0, const Options<S> &options,
+                            const ErrorValue<T, E>&... p) {
+        using D = Dual<S, 1>;
+        S x = static_cast<S>(x0);
+        const S t = static_cast<S>(target.value);
+        for (std::size_t i = 0; i < options.maxIterations; ++i) {
+            const D r = f(D(x, 0), D(static_cast<S>(p.value))...) - t;
+            if (r.value == 0)
+                return implicit(f, x, target, p...);
+            if (r.grad[0] == 0 || !std::isfinite(r.grad[0]))
+                throw std::runtime_error("Newton iteration hit a zero derivative at " + std::to_string(x));
+            const S step = r.value/r.grad[0];
+            x -= step;
+            if (converged(options, step, x))
+                return implicit(f, x, target, p...);
+        }
+        throw std::runtime_error("Newton iteration did not converge in " + std::to_string(options.maxIterations) +
+                                 " iterations");
+    }
+
+    template <typename F, typename X, typename TT, typename TE, typename... T, typename... E,
+              typename S = std::common_type_t<X, TE, E...>>
+    ErrorValue<S, S> newton(F &&f, const ErrorValue<TT, TE> &target, X x0, const ErrorValue<T, E>&... p) {
+        return newton(f, target, x0, Options<S>(), p...);
+    }
+
+    //------- BRENT -------
+
+    // Brent's method on a bracket [lo, hi] with a sign change of f(x, p...) - target
+    template <typename F, typename X, typename TT, typename TE, typename... T, typename... E,
+              typename S = std::common_type_t<X, TE, E...>>
+    ErrorValue<S, S> brent(F &&f, const ErrorValue<TT, TE> &target, X lo, X hi, const Options<S> &options,
+                           const ErrorValue<T, E>&... p) {
+        const S t = static_cast<S>(target.value);
+        S a = static_cast<S>(lo), b = static_cast<S>(hi);
+        S fa = residual(f, a, t, p...), fb = residual(f, b, t, p...);
+        if ((fa > 0 && fb > 0) || (fa < 0 && fb < 0))
+            throw std::invalid_argument("Root is not bracketed by [" + std::to_string(a) + ", " +
+                                        std::to_string(b) + "]");
+        S c = b, fc = fb, d = b - a, e = d;
+        for (std::size_t i = 0; i < options.maxIterations; ++i) {
+            if ((fb > 0 && fc > 0) || (fb < 0 && fc < 0)) {
+                c = a, fc = fa;
+                e = d = b - a;
+            }
+            if (std::abs(fc) < std::abs(fb)) {
+                a = b, b = c, c = a;
+                fa = fb, fb = fc, fc = fa;
+            }
+            const S tol = std::numeric_limits<S>::epsilon()*std::abs(b) + options.tolerance*(1 + std::abs(b))/2;
+            const S m = (c - b)/2;
+            if (std::abs(m) <= tol || fb == 0)
+                return implicit(f, b, target, p...);
+            if (std::abs(e) >= tol && std::abs(fa) > std::abs(fb)) {
+                // Inverse quadratic interpolation, or secant if only two points are distinct
+                S s = fb/fa, q, r, num;
+                if (a == c) {
+                    num = 2*m*s;
+                    q = 1 - s;
+                } else {
+                    q = fa/fc, r = fb/fc;
+                    num = s*(2*m*q*(q - r) - (b - a)*(r - 1));
+                    q = (q - 1)*(r - 1)*(s - 1);
+                }
+                if (num > 0)
+                    q = -q;
+                num = std::abs(num);
+                if (2*num < std::min(3*m*q - std::abs(tol*q), std::abs(e*q))) {
+                    e = d;
+                    d = num/q;
+                } else {
+                    d = m;
+                    e = d;
+                }
+            } else {
+                d = m;
+                e = d;
+            }
+            a = b, fa = fb;
+            b += std::abs(d) > tol ? d : std::copysign(tol, m);
+            fb = residual(f, b, t, p...);
+        }
+        throw std::runtime_error("Brent's method did not converge in " + std::to_string(options.maxIterations) +
+                                 " iterations");
+    }
+
+    template <typename F, typename X, typename TT, typename TE, typename... T, typename... E,
+              typename S = std::common_type_t<X, TE, E...>>
+    ErrorValue<S, S> brent(F &&f, const ErrorValue<TT, TE> &target, X lo, X hi, const ErrorValue<T, E>&... p) {
+        return brent(f, target, lo, hi, Options<S>(), p...);
+    }
+
+    //------- BATCHED SOLVERS -------
+
+    // Calls solve(i) for every instance on options.threads threads. Instances that throw get a NaN value and
+    // error instead of stopping the whole batch.
+    template <typename T, typename Solve>
+    ErrorArray<T> solveAll(std::size_t n, const Options<T> &options, Solve solve) {
+        ErrorArray<T> res(n);
+        parallel::forRanges(n, options.threads, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                try {
+                    ErrorValue<T, T> x = solve(i);
+                    res.set(i, x.value, x.error);
+                } catch (const std::exception &) {
+                    res.set(i, std::numeric_limits<T>::quiet_NaN(), std::numeric_limits<T>::quiet_NaN());
+                }
+            }
+        });
+        return res;
+    }
+
+    template <typename T, typename... P>
+    void checkSizes(std::size_t n, const std::vector<T> &x, const P&... p) {
+        for (std::size_t size : {x.size(), p.size()...})
+            if (size != n)
+                throw std::invalid_argument("Batch sizes must match: " + std::to_string(n) + " and " +
+                                            std::to_string(size));
+    }
+
+    // Instance i solves f(x, p[i]...) = target[i] from x0[i]
+    template <typename F, typename T, typename... P>
+    ErrorArray<T> newton(F &&f, const ErrorArray<T> &target, const std::vector<T> &x0, const Options<T> &options,
+                         const P&... p) {
+        static_assert((std::is_same<P, ErrorArray<T>>::value && ...), "Batched parameters must be ErrorArrays");
+        checkSizes(target.size(), x0, p...);
+        return solveAll(target.size(), options, [&](std::size_t i) {
+            return newton(f, target[i], x0[i], options, p[i]...);
+        });
+    }
+
+    template <typename F, typename T, typename... P>
+    ErrorArray<T> newton(F &&f, const ErrorArray<T> &target, const std::vector<T> &x0, const P&... p) {
+        return newton(f, target, x0, Options<T>(), p...);
+    }
+
+    // Instance i solves f(x, p[i]...) = target[i] on [lo[i], hi[i]]
+    template <typename F, typename T, typename... P>
+    ErrorArray<T> brent(F &&f, const ErrorArray<T> &target, const std::vector<T> &lo, const std::vector<T> &hi,
+                        const Options<T> &options, const P&... p) {
+        static_assert((std::is_same<P, ErrorArray<T>>::value && ...), "Batched parameters must be ErrorArrays");
+        checkSizes(target.size(), lo, hi, p...);
+        return solveAll(target.size(), options, [&](std::size_t i) {
+            return brent(f, target[i], lo[i], hi[i], options, p[i]...);
+        });
+    }
+
+    template <typename F, typename T, typename... P>
+    ErrorArray<T> brent(F &&f, const ErrorArray<T> &target, const std::vector<T> &lo, const std::vector<T> &hi,
+                        const P&... p) {
+        return brent(f, target, lo, hi, Options<T>(), p...);
+    }
+
+}
+
+#endif //LIBERRC_ERRC_SOLVE_H
@@ -0,0 +1,612 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_STREAM_H
+#define LIBERRC_ERRC_STREAM_H
+
+// Streaming ingestion. Producers fill fixed-size chunks of raw readings (ErrorArray, SoA) and hand them to a chain
+// of stages, one thread each, through bounded lock-free rings: an MPSC ring from the producers to the first stage
+// and SPSC rings between stages. The last stage returns a chunk to the pool of its producer, so memory is bounded
+// and a producer whose chunks are all in flight waits, or is refused by tryPush, until the stages catch up.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "errc.h"
+#include "errc_batch.h"
+
+namespace liberrc::stream {
+
+    constexpr std::size_t CACHE_LINE = 64;
+
+    // Spins a little, then yields, then sleeps, so idle stages do not hold a core
+    class Backoff {
+    public:
+
+        void wait() {
+            ++rounds;
+            if (rounds < SPINS)
+                return;
+            if (rounds < SPINS + YIELDS)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+
+        void reset() {
+            rounds = 0;
+        }
+
+    protected:
+
+        static constexpr unsigned SPINS = 16, YIELDS = 1024;
+        unsigned rounds = 0;
+    };
+
+    inline std::size_t ringCapacity(std::size_t requested) {
+        std::size_t capacity = 2;
+        while (capacity < requested)
+            capacity *= 2;
+        return capacity;
+    }
+
+    //------- RINGS -------
+
+    // Bounded ring for one producer and one consumer thread, capacity is rounded up to a power of two
+    template <typename V>
+    class SpscRing {
+    public:
+
+        explicit SpscRing(std::size_t capacity) : slots(ringCapacity(capacity)), mask(slots.size() - 1) {};
+
+        // Producer side, false if the ring is full
+        bool tryPush(V v) {
+            const std::size_t t = tail.load(std::memory_order_relaxed);
+            if (t - headCache == slots.size()) {
+                headCache = head.load(std::memory_order_acquire);
+                if (t - headCache == slots.size())
+                    return false;
+            }
+            slots[t & mask] = std::move(v);
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side, false if the ring is empty
+        bool tryPop(V &v) {
+            const std::size_t h = head.load(std::memory_order_relaxed);
+            if (h == tailCache) {
+                tailCache = tail.load(std::memory_order_acquire);
+                if (h == tailCache)
+                    return false;
+            }
+            v = std::move(slots[h & mask]);
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        [[nodiscard]] std::size_t capacity() const {
+            return slots.size();
+        }
+
+        // Exact only when called from one of the two threads while the other is idle
+        [[nodiscard]] std::size_t size() const {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+
+    protected:
+
+        std::vector<V> slots;
+        std::size_t mask;
+        // Consumer line
+        alignas(CACHE_LINE) std::atomic<std::size_t> head{0};
+        std::size_t tailCache = 0;
+        // Producer line
+        alignas(CACHE_LINE) std::atomic<std::size_t> tail{0};
+        std::size_t headCache = 0;
+    };
+
+    // Bounded ring for many producer threads and one consumer thread. Every cell carries a sequence number that
+    // tells whether it is free for the lap of a producer or filled for the lap of the consumer, so producers only
+    // contend on the compare-and-swap of the tail.
+    template <typename V>
+    class MpscRing {
+    public:
+
+        explicit MpscRing(std::size_t capacity) : cells(ringCapacity(capacity)), mask(cells.size() - 1) {
+            for (std::size_t i = 0; i < cells.size(); ++i)
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+        };
+
+        // Any thread, false if the ring is full
+        bool tryPush(V v) {
+            std::size_t pos = tail.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell &c = cells[pos & mask];
+                std::size_t sequence = c.sequence.load(std::memory_order_acquire);
+                if (sequence == pos) {
+                    if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        c.value = std::move(v);
+                        c.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (static_cast<std::ptrdiff_t>(sequence - pos) < 0) {
+                    return false;
+                } else {
+                    pos = tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Consumer thread only, false if the ring is empty
+        bool tryPop(V &v) {
+            Cell &c = cells[head & mask];
+            if (c.sequence.load(std::memory_order_acquire) != head + 1)
+                return false;
+            v = std::move(c.value);
+            c.sequence.store(head + cells.size(), std::memory_order_release);
+            ++head;
+            return true;
+        }
+
+        [[nodiscard]] std::size_t capacity() const {
+            return cells.size();
+        }
+
+    protected:
+
+        struct Cell {
+            std::atomic<std::size_t> sequence{0};
+            V value{};
+        };
+
+        std::vector<Cell> cells;
+        std::size_t mask;
+        alignas(CACHE_LINE) std::atomic<std::size_t> tail{0};
+        alignas(CACHE_LINE) std::size_t head = 0;
+    };
+
+    //------- STAGES -------
+
+    // Readings of one chunk seen by a stage, transformed in place
+    template <typename T>
+    struct Batch {
+        T* value;
+        T* error;
+        std::size_t size;
+    };
+
+    template <typename T>
+    using Stage = std::function<void(Batch<T>&)>;
+
+    // Sets the error of raw readings like assigning them to an ErrorValue with this default error method
+    template <typename T>
+    Stage<T> defaultError(int code, std::function<T(T)> fun = nullptr) {
+        ErrorValue<T, T> prototype(0, 0);
+        prototype.setDefaultErrorCalculationMethod(code, std::move(fun));
+        if (code == ErrorValue<T, T>::DEF_ERROR_FUNC && !prototype.getDefaultErrorCalcFunction())
+            throw std::bad_function_call();
+        return [prototype](Batch<T> &b) mutable {
+            for (std::size_t i = 0; i < b.size; ++i) {
+                prototype = b.value[i];
+                b.error[i] = prototype.error;
+            }
+        };
+    }
+
+    // Replaces every reading x by f(x), f takes an ErrorValue<T, T> and may use errmath
+    template <typename T, typename F>
+    Stage<T> formula(F f) {
+        return [f](Batch<T> &b) mutable {
+            for (std::size_t i = 0; i < b.size; ++i) {
+                auto r = f(ErrorValue<T, T>(b.value[i], b.error[i]));
+                b.value[i] = static_cast<T>(r.value);
+                b.error[i] = static_cast<T>(r.error);
+            }
+        };
+    }
+
+    //------- STATISTICS -------
+
+    constexpr std::size_t LATENCY_BUCKETS = 64;
+
+    struct StageStats {
+        std::uint64_t chunks = 0, items = 0;
+        // Time spent in the stage callback
+        double busySeconds = 0;
+        // Chunks by floor(log2) of the nanoseconds from their first reading to the end of this stage, so the
+        // histogram of the last stage is the end-to-end latency
+        std::array<std::uint64_t, LATENCY_BUCKETS> latency{};
+
+        // Readings per second of callback time, the rate the stage could sustain alone
+        [[nodiscard]] double throughput() const {
+            return busySeconds > 0 ? static_cast<double>(items)/busySeconds : 0;
+        }
+
+        // Upper bound of the latency of a fraction p of the chunks, in seconds
+        [[nodiscard]] double latencyPercentile(double p) const {
+            if (chunks == 0)
+                return 0;
+            const double target = p*static_cast<double>(chunks);
+            std::uint64_t seen = 0;
+            for (std::size_t b = 0; b < LATENCY_BUCKETS; ++b) {
+                seen += latency[b];
+                if (seen != 0 && static_cast<double>(seen) >= target)
+                    return std::ldexp(1.0, static_cast<int>(b) + 1)*1e-9;
+            }
+            return std::ldexp(1.0, LATENCY_BUCKETS)*1e-9;
+        }
+    };
+
+    //------- PIPELINE -------
+
+    struct Options {
+        // Readings per chunk
+        std::size_t chunkSize = 4096;
+        // Chunks each producer owns, the bound on its readings in flight
+        std::size_t chunksPerProducer = 8;
+        // Capacity of the rings between producers and stages, in chunks
+        std::size_t queueChunks = 64;
+    };
+
+    template <typename T>
+    class Pipeline {
+
+        static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+                      "Type of streamed readings must be float or double");
+
+        using Clock = std::chrono::steady_clock;
+
+        struct Chunk {
+            ErrorArray<T> data;
+            std::size_t size = 0;
+            // A stage threw on this chunk, later stages skip it
+            bool failed = false;
+            Clock::time_point created;
+            // Pool of the producer the chunk returns to
+            SpscRing<Chunk*>* home = nullptr;
+        };
+
+    public:
+
+        // Handle of one producer thread, not thread safe. It must be destroyed before the pipeline; the
+        // destructor submits the last partial chunk and waits until every chunk came back.
+        class Producer {
+        public:
+
+            Producer(Producer&&) noexcept = default;
+            Producer& operator=(Producer&&) = delete;
+            Producer(const Producer&) = delete;
+
+            ~Producer() {
+                if (!state)
+                    return;
+                // The last readings are dropped if the pipeline was closed meanwhile
+                if (state->current != nullptr && state->current->size != 0 && !state->pipeline->isClosed()) {
+                    try {
+                        submit(true);
+                    } catch (const std::logic_error&) {
+                    }
+                }
+                Chunk* c = nullptr;
+                Backoff backoff;
+                while (state->outstanding != 0) {
+                    if (state->pool.tryPop(c)) {
+                        --state->outstanding;
+                        continue;
+                    }
+                    backoff.wait();
+                }
+            }
+
+            // Waits for a free chunk when all are in flight
+            void push(T value) {
+                // Full only after a submit threw, pushing again throws again instead of writing past the chunk
+                if (state->current != nullptr && state->current->size == state->pipeline->options.chunkSize)
+                    submit(true);
+                if (state->current == nullptr)
+                    acquire(true);
+                write(value);
+                if (state->current->size == state->pipeline->options.chunkSize)
+                    submit(true);
+            }
+
+            // Refuses the reading instead of waiting
+            bool tryPush(T value) {
+                if (state->current != nullptr && state->current->size == state->pipeline->options.chunkSize &&
+                    !submit(false))
+                    return false;
+                if (state->current == nullptr && !acquire(false))
+                    return false;
+                write(value);
+                if (state->current->size == state->pipeline->options.chunkSize)
+                    submit(false);
+                return true;
+            }
+
+            void push(const T* values, std::size_t n) {
+                const std::size_t chunkSize = state->pipeline->options.chunkSize;
+                while (n != 0) {
+                    if (state->current != nullptr && state->current->size == chunkSize)
+                        submit(true);
+                    if (state->current == nullptr)
+                        acquire(true);
+                    Chunk &c = *state->current;
+                    if (c.size == 0)
+                        c.created = Clock::now();
+                    std::size_t m = std::min(n, chunkSize - c.size);
+                    std::copy(values, values + m, c.data.value.data() + c.size);
+                    std::fill_n(c.data.error.data() + c.size, m, T(0));
+                    c.size += m, values += m, n -= m;
+                    if (c.size == chunkSize)
+                        submit(true);
+                }
+            }
+
+            // Submits the partial chunk, so its readings do not wait for the chunk to fill
+            void flush() {
+                if (state->current != nullptr && state->current->size != 0)
+                    submit(true);
+            }
+
+        protected:
+
+            friend class Pipeline;
+
+            struct State {
+                Pipeline* pipeline;
+                SpscRing<Chunk*> pool;
+                std::vector<std::unique_ptr<Chunk>> chunks;
+                Chunk* current = nullptr;
+                // Chunks not in the hands of the producer, in the pool or in flight
+                std::size_t outstanding = 0;
+
+                State(Pipeline* pipeline_, std::size_t count) : pipeline(pipeline_), pool(count) {};
+            };
+
+            std::unique_ptr<State> state;
+
+            explicit Producer(Pipeline* pipeline) {
+                const std::size_t count = std::max<std::size_t>(1, pipeline->options.chunksPerProducer);
+                state = std::make_unique<State>(pipeline, count);
+                for (std::size_t i = 0; i < count; ++i) {
+                    state->chunks.push_back(std::make_unique<Chunk>());
+                    Chunk &c = *state->chunks.back();
+                    c.data.resize(pipeline->options.chunkSize);
+                    c.home = &state->pool;
+                    state->pool.tryPush(&c);
+                }
+                state->outstanding = count;
+            }
+
+            // Raw readings are exact until a stage sets their error, a recycled chunk still holds the old ones
+            void write(T value) {
+                Chunk &c = *state->current;
+                if (c.size == 0)
+                    c.created = Clock::now();
+                c.data.error[c.size] = 0;
+                c.data.value[c.size++] = value;
+            }
+
+            bool acquire(bool wait) {
+                Backoff backoff;
+                while (!state->pool.tryPop(state->current)) {
+                    if (!wait)
+                        return false;
+                    backoff.wait();
+                }
+                --state->outstanding;
+                state->current->size = 0;
+                state->current->failed = false;
+                return true;
+            }
+
+            bool submit(bool wait) {
+                Pipeline &p = *state->pipeline;
+                // Announced before closed is read and stage 0 reads them the other way round (both seq_cst), so
+                // either this sees the close or stage 0 keeps draining until the chunk is in the ring
+                p.submitting.fetch_add(1);
+                if (p.closed.load()) {
+                    p.submitting.fetch_sub(1);
+                    throw std::logic_error("Readings pushed to a closed pipeline");
+                }
+                Backoff backoff;
+                while (!p.ingress.tryPush(state->current)) {
+                    if (!wait) {
+                        p.submitting.fetch_sub(1);
+                        return false;
+                    }
+                    backoff.wait();
+                }
+                p.submitting.fetch_sub(1);
+                state->current = nullptr;
+                ++state->outstanding;
+                return true;
+            }
+        };
+
+        //------- CONSTRUCTORS -------
+
+        // Starts one thread per stage, the last stage is usually the sink that stores the results
+        explicit Pipeline(std::vector<Stage<T>> stages_, Options options_ = Options())
+                : options(options_), ingress(options_.queueChunks), stages(std::move(stages_)) {
+            if (stages.empty())
+                throw std::invalid_argument("Pipeline needs at least one stage");
+            if (options.chunkSize == 0)
+                throw std::invalid_argument("Pipeline chunks must hold at least one reading");
+            for (std::size_t i = 0; i < stages.size(); ++i) {
+                states.push_back(std::make_unique<StageState>());
+                if (i + 1 < stages.size())
+                    links.push_back(std::make_unique<SpscRing<Chunk*>>(options.queueChunks));
+            }
+            for (std::size_t i = 0; i < stages.size(); ++i)
+                threads.emplace_back([this, i]() { run(i); });
+        }
+
+        Pipeline(const Pipeline&) = delete;
+        Pipeline& operator=(const Pipeline&) = delete;
+
+        ~Pipeline() {
+            try {
+                close();
+            } catch (...) {
+            }
+        }
+
+        //------- METHODS -------
+
+        [[nodiscard]] Producer producer() {
+            return Producer(this);
+        }
+
+        // Call once every producer flushed: processes the submitted chunks, stops the stages and rethrows the
+        // first exception thrown by a stage callback. A chunk a stage threw on skips the later stages. Producers
+        // still pushing get a std::logic_error once their chunk fills, the chunks they submitted are processed.
+        void close() {
+            closed.store(true);
+            for (std::thread &t : threads)
+                if (t.joinable())
+                    t.join();
+            for (const std::unique_ptr<StageState> &s : states)
+                if (s->error)
+                    std::rethrow_exception(std::exchange(s->error, nullptr));
+        }
+
+        [[nodiscard]] bool isClosed() const {
+            return closed.load(std::memory_order_acquire);
+        }
+
+        // Snapshot of the counters, may be taken while the pipeline runs
+        [[nodiscard]] std::vector<StageStats> stats() const {
+            std::vector<StageStats> res(states.size());
+            for (std::size_t i = 0; i < states.size(); ++i) {
+                const StageState &s = *states[i];
+                res[i].chunks = s.chunks.load(std::memory_order_relaxed);
+                res[i].items = s.items.load(std::memory_order_relaxed);
+                res[i].busySeconds = static_cast<double>(s.busy.load(std::memory_order_relaxed))*1e-9;
+                for (std::size_t b = 0; b < LATENCY_BUCKETS; ++b)
+                    res[i].latency[b] = s.latency[b].load(std::memory_order_relaxed);
+            }
+            return res;
+        }
+
+    protected:
+
+        // Counters are written by the stage thread only
+        struct StageState {
+            std::atomic<std::uint64_t> chunks{0}, items{0}, busy{0};
+            std::array<std::atomic<std::uint64_t>, LATENCY_BUCKETS> latency{};
+            std::atomic<bool> done{false};
+            std::exception_ptr error = nullptr;
+        };
+
+        Options options;
+        MpscRing<Chunk*> ingress;
+        std::vector<Stage<T>> stages;
+        std::vector<std::unique_ptr<SpscRing<Chunk*>>> links;
+        std::vector<std::unique_ptr<StageState>> states;
+        std::vector<std::thread> threads;
+        std::atomic<bool> closed{false};
+        // Producers inside submit, stage 0 only stops once it is 0 after the close
+        std::atomic<std::size_t> submitting{0};
+
+        static void add(std::atomic<std::uint64_t> &counter, std::uint64_t n) {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        bool pop(std::size_t i, Chunk* &c) {
+            return i == 0 ? ingress.tryPop(c) : links[i - 1]->tryPop(c);
+        }
+
+        bool upstreamDone(std::size_t i) const {
+            if (i == 0)
+                return closed.load() && submitting.load() == 0;
+            return states[i - 1]->done.load(std::memory_order_acquire);
+        }
+
+        void run(std::size_t i) {
+            StageState &s = *states[i];
+            Backoff backoff;
+            for (;;) {
+                Chunk* c = nullptr;
+                if (!pop(i, c)) {
+                    // Upstream pushes everything before it is done, so a pop after seeing done finds the last chunks
+                    bool done = upstreamDone(i);
+                    if (!pop(i, c)) {
+                        if (done)
+                            break;
+                        backoff.wait();
+                        continue;
+                    }
+                }
+                backoff.reset();
+                process(s, stages[i], *c);
+                if (i + 1 < stages.size()) {
+                    while (!links[i]->tryPush(c))
+                        backoff.wait();
+                    backoff.reset();
+                } else {
+                    c->home->tryPush(c);
+                }
+            }
+            s.done.store(true, std::memory_order_release);
+        }
+
+        void process(StageState &s, Stage<T> &stage, Chunk &c) {
+            Clock::time_point start = Clock::now();
+            if (!c.failed) {
+                Batch<T> batch{c.data.value.data(), c.data.error.data(), c.size};
+                try {
+                    stage(batch);
+                } catch (...) {
+                    if (!s.error)
+                        s.error = std::current_exception();
+                    c.failed = true;
+                }
+            }
+            Clock::time_point end = Clock::now();
+            add(s.busy, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    end - start).count()));
+            auto latency = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    end - c.created).count());
+            std::size_t bucket = 0;
+            while (latency >>= 1)
+                ++bucket;
+            add(s.latency[bucket], 1);
+            add(s.chunks, 1);
+            add(s.items, c.size);
+        }
+
+    };
+
+}
+
+#endif //LIBERRC_ERRC_STREAM_H
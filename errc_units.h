@@ -0,0 +1,551 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ERRC_UNITS_H
+#define LIBERRC_ERRC_UNITS_H
+
+// Compile-time physical units. Quantity<Unit, T, E> holds exactly one ErrorValue<T, E> expressed in Unit, a
+// dimension (exponents of the SI base dimensions) and an exact std::ratio scale. Dimensions are checked and scale
+// factors folded during compilation: mixing dimensions does not compile, quantities of the same unit cost exactly
+// the ErrorValue operations, and a conversion between scales is one multiplication by a constant.
+
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <ostream>
+#include <ratio>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "errc.h"
+
+namespace liberrc::units {
+
+    //------- DIMENSIONS -------
+
+    // Exponents of length, mass, time, electric current, temperature, amount of substance and luminous intensity
+    template <int L, int M, int Ti, int I, int Th, int N, int J>
+    struct Dimension {
+        static constexpr std::array<int, 7> exponents = {L, M, Ti, I, Th, N, J};
+    };
+
+    template <typename A, typename B>
+    struct DimensionProduct;
+
+    template <int... A, int... B>
+    struct DimensionProduct<Dimension<A...>, Dimension<B...>> {
+        using type = Dimension<(A + B)...>;
+    };
+
+    template <typename A, typename B>
+    struct DimensionQuotient;
+
+    template <int... A, int... B>
+    struct DimensionQuotient<Dimension<A...>, Dimension<B...>> {
+        using type = Dimension<(A - B)...>;
+    };
+
+    template <typename D, int P>
+    struct DimensionPower;
+
+    template <int... A, int P>
+    struct DimensionPower<Dimension<A...>, P> {
+        using type = Dimension<(A*P)...>;
+    };
+
+    template <typename D, int R>
+    struct DimensionRoot;
+
+    template <int... A, int R>
+    struct DimensionRoot<Dimension<A...>, R> {
+        static_assert(((A%R == 0) && ...), "Root of a quantity needs dimension exponents divisible by its order");
+        using type = Dimension<(A/R)...>;
+    };
+
+    using Dimensionless = Dimension<0, 0, 0, 0, 0, 0, 0>;
+    using Length = Dimension<1, 0, 0, 0, 0, 0, 0>;
+    using Mass = Dimension<0, 1, 0, 0, 0, 0, 0>;
+    using Time = Dimension<0, 0, 1, 0, 0, 0, 0>;
+    using Current = Dimension<0, 0, 0, 1, 0, 0, 0>;
+    using Temperature = Dimension<0, 0, 0, 0, 1, 0, 0>;
+    using Amount = Dimension<0, 0, 0, 0, 0, 1, 0>;
+    using LuminousIntensity = Dimension<0, 0, 0, 0, 0, 0, 1>;
+
+    using Area = Dimension<2, 0, 0, 0, 0, 0, 0>;
+    using Volume = Dimension<3, 0, 0, 0, 0, 0, 0>;
+    using Frequency = Dimension<0, 0, -1, 0, 0, 0, 0>;
+    using Velocity = Dimension<1, 0, -1, 0, 0, 0, 0>;
+    using Acceleration = Dimension<1, 0, -2, 0, 0, 0, 0>;
+    using Force = Dimension<1, 1, -2, 0, 0, 0, 0>;
+    using Pressure = Dimension<-1, 1, -2, 0, 0, 0, 0>;
+    using Energy = Dimension<2, 1, -2, 0, 0, 0, 0>;
+    using Power = Dimension<2, 1, -3, 0, 0, 0, 0>;
+    using Charge = Dimension<0, 0, 1, 1, 0, 0, 0>;
+    using Voltage = Dimension<2, 1, -3, -1, 0, 0, 0>;
+    using Resistance = Dimension<2, 1, -3, -2, 0, 0, 0>;
+
+    //------- UNITS -------
+
+    // Dimension D times the exact factor Scale of its coherent SI unit
+    template <typename D, typename Scale = std::ratio<1>>
+    struct Unit {
+        using dimension = D;
+        using scale = typename Scale::type;
+    };
+
+    template <typename U1, typename U2>
+    using UnitProduct = Unit<typename DimensionProduct<typename U1::dimension, typename U2::dimension>::type,
+                             std::ratio_multiply<typename U1::scale, typename U2::scale>>;
+
+    template <typename U1, typename U2>
+    using UnitQuotient = Unit<typename DimensionQuotient<typename U1::dimension, typename U2::dimension>::type,
+                              std::ratio_divide<typename U1::scale, typename U2::scale>>;
+
+    // Largest scale both scales are integer multiples of, like std::chrono::duration
+    template <typename S1, typename S2>
+    using CommonScale = typename std::ratio<std::gcd(S1::num, S2::num), std::lcm(S1::den, S2::den)>::type;
+
+    template <typename U1, typename U2>
+    using CommonUnit = std::conditional_t<std::is_same<U1, U2>::value, U1,
+                                          Unit<typename U1::dimension,
+                                               CommonScale<typename U1::scale, typename U2::scale>>>;
+
+    using One = Unit<Dimensionless>;
+    using Percent = Unit<Dimensionless, std::centi>;
+    using PartsPerMillion = Unit<Dimensionless, std::micro>;
+
+    using Metre = Unit<Length>;
+    using Kilometre = Unit<Length, std::kilo>;
+    using Centimetre = Unit<Length, std::centi>;
+    using Millimetre = Unit<Length, std::milli>;
+    using Micrometre = Unit<Length, std::micro>;
+    using Nanometre = Unit<Length, std::nano>;
+
+    using Kilogram = Unit<Mass>;
+    using Gram = Unit<Mass, std::milli>;
+    using Milligram = Unit<Mass, std::micro>;
+
+    using Second = Unit<Time>;
+    using Millisecond = Unit<Time, std::milli>;
+    using Microsecond = Unit<Time, std::micro>;
+    using Nanosecond = Unit<Time, std::nano>;
+    using Minute = Unit<Time, std::ratio<60>>;
+    using Hour = Unit<Time, std::ratio<3600>>;
+
+    using Ampere = Unit<Current>;
+    using Milliampere = Unit<Current, std::milli>;
+    using Kelvin = Unit<Temperature>;
+    using Mole = Unit<Amount>;
+    using Candela = Unit<LuminousIntensity>;
+
+    using SquareMetre = Unit<Area>;
+    using CubicMetre = Unit<Volume>;
+    using Litre = Unit<Volume, std::milli>;
+    using Hertz = Unit<Frequency>;
+    using Kilohertz = Unit<Frequency, std::kilo>;
+    using MetrePerSecond = Unit<Velocity>;
+    using KilometrePerHour = Unit<Velocity, std::ratio<1000, 3600>>;
+    using MetrePerSecondSquared = Unit<Acceleration>;
+    using Newton = Unit<Force>;
+    using Pascal = Unit<Pressure>;
+    using Kilopascal = Unit<Pressure, std::kilo>;
+    using Joule = Unit<Energy>;
+    using Kilojoule = Unit<Energy, std::kilo>;
+    using Watt = Unit<Power>;
+    using Kilowatt = Unit<Power, std::kilo>;
+    using Coulomb = Unit<Charge>;
+    using Volt = Unit<Voltage>;
+    using Millivolt = Unit<Voltage, std::milli>;
+    using Ohm = Unit<Resistance>;
+    using Kiloohm = Unit<Resistance, std::kilo>;
+
+    //------- SCALING -------
+
+    template <typename S, typename T>
+    constexpr T SCALE_FACTOR = static_cast<T>(S::num)/static_cast<T>(S::den);
+
+    // x times the exact factor S; x itself when S is one, so same-unit arithmetic never copies
+    template <typename S, typename T, typename E>
+    decltype(auto) rescale(const ErrorValue<T, E> &x) {
+        if constexpr (S::num == S::den) {
+            return x;
+        } else {
+            ErrorValue<T, E> res = x;
+            res.value *= SCALE_FACTOR<S, T>;
+            res.error *= SCALE_FACTOR<S, E>;
+            return res;
+        }
+    }
+
+    // Errmath of float returns double ErrorValues, brings them back to the types of the quantity
+    template <typename T, typename E, typename R>
+    ErrorValue<T, E> narrow(R &&r) {
+        if constexpr (std::is_same<std::decay_t<R>, ErrorValue<T, E>>::value)
+            return std::forward<R>(r);
+        else
+            return ErrorValue<T, E>(static_cast<T>(r.value), static_cast<E>(r.error));
+    }
+
+    //------- QUANTITY -------
+
+    template <typename U, typename T = double, typename E = T>
+    class Quantity {
+
+        static_assert(std::is_floating_point<T>::value, "Type of Quantity value must be float, double or long double");
+
+    public:
+
+        using unit = U;
+        using dimension = typename U::dimension;
+        using scale = typename U::scale;
+
+        //------- CONSTRUCTORS -------
+
+        [[nodiscard]] Quantity() = default;
+        [[nodiscard]] Quantity(T value_, E error_) : ev(value_, error_) {};
+        [[nodiscard]] explicit Quantity(const ErrorValue<T, E> &ev_) : ev(ev_) {};
+        [[nodiscard]] explicit Quantity(ErrorValue<T, E> &&ev_) : ev(std::move(ev_)) {};
+
+        // Exact conversion from another unit of the same dimension
+        template <typename U2>
+        [[nodiscard]] Quantity(const Quantity<U2, T, E> &q)
+                : ev(rescale<std::ratio_divide<typename U2::scale, scale>>(q.errorValue())) {
+            static_assert(std::is_same<typename U2::dimension, dimension>::value,
+                          "Quantities of different dimensions can not be converted");
+        };
+
+        //------- COMPOUND ASSIGMENT OPERATORS -------
+
+        Quantity& operator+=(const Quantity &q) {
+            ev += q.ev;
+            return *this;
+        }
+
+        Quantity& operator-=(const Quantity &q) {
+            ev -= q.ev;
+            return *this;
+        }
+
+        Quantity& operator*=(T value_) {
+            ev *= value_;
+            return *this;
+        }
+
+        Quantity& operator/=(T value_) {
+            ev /= value_;
+            return *this;
+        }
+
+        //------- ARITHMETIC OPERATORS -------
+
+        Quantity operator+() const {
+            return *this;
+        }
+
+        Quantity operator-() const {
+            return Quantity(-ev);
+        }
+
+        //------- NON-VOID METHODS -------
+
+        [[nodiscard]] const ErrorValue<T, E>& errorValue() const {
+            return ev;
+        }
+
+        [[nodiscard]] T value() const {
+            return ev.value;
+        }
+
+        [[nodiscard]] E error() const {
+            return ev.error;
+        }
+
+        // Value and error in unit U2
+        template <typename U2>
+        [[nodiscard]] Quantity<U2, T, E> in() const {
+            return Quantity<U2, T, E>(*this);
+        }
+
+    protected:
+
+        ErrorValue<T, E> ev;
+    };
+
+    // ErrorValue of q expressed in unit U2 of the same dimension
+    template <typename U2, typename U, typename T, typename E>
+    decltype(auto) errorValueIn(const Quantity<U, T, E> &q) {
+        return rescale<std::ratio_divide<typename U::scale, typename U2::scale>>(q.errorValue());
+    }
+
+    //------- ARITHMETIC -------
+
+    template <typename U1, typename U2, typename T, typename E>
+    Quantity<CommonUnit<U1, U2>, T, E> operator+(const Quantity<U1, T, E> &a, const Quantity<U2, T, E> &b) {
+        static_assert(std::is_same<typename U1::dimension, typename U2::dimension>::value,
+                      "Added quantities must have the same dimension");
+        using C = CommonUnit<U1, U2>;
+        return Quantity<C, T, E>(errorValueIn<C>(a) + errorValueIn<C>(b));
+    }
+
+    template <typename U1, typename U2, typename T, typename E>
+    Quantity<CommonUnit<U1, U2>, T, E> operator-(const Quantity<U1, T, E> &a, const Quantity<U2, T, E> &b) {
+        static_assert(std::is_same<typename U1::dimension, typename U2::dimension>::value,
+                      "Subtracted quantities must have the same dimension");
+        using C = CommonUnit<U1, U2>;
+        return Quantity<C, T, E>(errorValueIn<C>(a) - errorValueIn<C>(b));
+    }
+
+    template <typename U1, typename U2, typename T, typename E>
+    Quantity<UnitProduct<U1, U2>, T, E> operator*(const Quantity<U1, T, E> &a, const Quantity<U2, T, E> &b) {
+        return Quantity<UnitProduct<U1, U2>, T, E>(a.errorValue()*b.errorValue());
+    }
+
+    template <typename U1, typename U2, typename T, typename E>
+    Quantity<UnitQuotient<U1, U2>, T, E> operator/(const Quantity<U1, T, E> &a, const Quantity<U2, T, E> &b) {
+        return Quantity<UnitQuotient<U1, U2>, T, E>(a.errorValue()/b.errorValue());
+    }
+
+    // Numbers are dimensionless and take the default error of the quantity, as in ErrorValue arithmetic
+    template <typename U, typename T, typename E>
+    Quantity<U, T, E> operator*(const Quantity<U, T, E> &q, T value_) {
+        return Quantity<U, T, E>(q.errorValue()*value_);
+    }
+
+    template <typename U, typename T, typename E>
+    Quantity<U, T, E> operator*(T value_, const Quantity<U, T, E> &q) {
+        return Quantity<U, T, E>(q.errorValue()*value_);
+    }
+
+    template <typename U, typename T, typename E>
+    Quantity<U, T, E> operator/(const Quantity<U, T, E> &q, T value_) {
+        return Quantity<U, T, E>(q.errorValue()/value_);
+    }
+
+    template <typename U, typename T, typename E>
+    Quantity<UnitQuotient<One, U>, T, E> operator/(T value_, const Quantity<U, T, E> &q) {
+        ErrorValue<T, E> x = q.errorValue();
+        x = value_;
+        return Quantity<UnitQuotient<One, U>, T, E>(x/q.errorValue());
+    }
+
+    //------- COMPARISON -------
+
+#define LIBERRC_UNITS_COMPARISON(op) \
+    template <typename U1, typename U2, typename T, typename E> \
+    bool operator op(const Quantity<U1, T, E> &a, const Quantity<U2, T, E> &b) { \
+        static_assert(std::is_same<typename U1::dimension, typename U2::dimension>::value, \
+                      "Compared quantities must have the same dimension"); \
+        using C = CommonUnit<U1, U2>; \
+        return errorValueIn<C>(a) op errorValueIn<C>(b); \
+    }
+
+    LIBERRC_UNITS_COMPARISON(==)
+    LIBERRC_UNITS_COMPARISON(!=)
+    LIBERRC_UNITS_COMPARISON(<)
+    LIBERRC_UNITS_COMPARISON(<=)
+    LIBERRC_UNITS_COMPARISON(>)
+    LIBERRC_UNITS_COMPARISON(>=)
+
+#undef LIBERRC_UNITS_COMPARISON
+
+    //------- OUTPUT -------
+
+    // "m^2 kg s^-2" in base SI units, with the scale in front when it is not one
+    template <typename U>
+    std::string symbol() {
+        static const char* const NAMES[] = {"m", "kg", "s", "A", "K", "mol", "cd"};
+        std::ostringstream os;
+        using S = typename U::scale;
+        if (S::num != S::den) {
+            os << S::num;
+            if (S::den != 1)
+                os << '/' << S::den;
+        }
+        for (std::size_t i = 0; i < 7; ++i) {
+            int p = U::dimension::exponents[i];
+            if (p == 0)
+                continue;
+            if (os.tellp() > 0)
+                os << ' ';
+            os << NAMES[i];
+            if (p != 1)
+                os << '^' << p;
+        }
+        return os.str();
+    }
+
+    template <typename U, typename T, typename E>
+    std::ostream& operator<<(std::ostream &os, const Quantity<U, T, E> &q) {
+        os << q.errorValue();
+        std::string s = symbol<U>();
+        if (!s.empty())
+            os << ' ' << s;
+        return os;
+    }
+
+    //------- ERRMATH -------
+
+#ifndef LIBERRC_NOT_ADD_ERRMATH
+
+    constexpr std::intmax_t integerRoot(std::intmax_t x, int order) {
+        std::intmax_t r = 0;
+        for (std::intmax_t next = 1;; ++next) {
+            std::intmax_t p = 1;
+            for (int i = 0; i < order; ++i) {
+                if (p > x/next)
+                    return r;
+                p *= next;
+            }
+            r = next;
+        }
+    }
+
+    constexpr bool isPower(std::intmax_t x, int order) {
+        std::intmax_t r = integerRoot(x, order), p = 1;
+        for (int i = 0; i < order; ++i)
+            p *= r;
+        return p == x;
+    }
+
+    // Root of order R of a unit: exact when the scale is an R-th power of a ratio, coherent otherwise
+    template <typename U, int R>
+    struct UnitRoot {
+        static constexpr bool EXACT = isPower(U::scale::num, R) && isPower(U::scale::den, R);
+        using scale = std::conditional_t<EXACT, std::ratio<integerRoot(U::scale::num, R), integerRoot(U::scale::den, R)>,
+                                         std::ratio<1>>;
+        using type = Unit<typename DimensionRoot<typename U::dimension, R>::type, scale>;
+        // Scale the argument is converted to before taking the root
+        using argument = Unit<typename U::dimension, std::conditional_t<EXACT, typename U::scale, std::ratio<1>>>;
+    };
+
+    template <typename U, typename T, typename E>
+    Quantity<typename UnitRoot<U, 2>::type, T, E> sqrt(const Quantity<U, T, E> &x) {
+        using R = UnitRoot<U, 2>;
+        return Quantity<typename R::type, T, E>(narrow<T, E>(::sqrt(errorValueIn<typename R::argument>(x))));
+    }
+
+    template <typename U, typename T, typename E>
+    Quantity<typename UnitRoot<U, 3>::type, T, E> cbrt(const Quantity<U, T, E> &x) {
+        using R = UnitRoot<U, 3>;
+        return Quantity<typename R::type, T, E>(narrow<T, E>(::cbrt(errorValueIn<typename R::argument>(x))));
+    }
+
+    template <typename U, int P>
+    struct UnitPower {
+        using type = Unit<typename DimensionPower<typename U::dimension, P>::type,
+                          std::ratio_multiply<typename UnitPower<U, P - 1>::type::scale, typename U::scale>>;
+    };
+
+    template <typename U>
+    struct UnitPower<U, 0> {
+        using type = One;
+    };
+
+    // Integer power known at compile time, units::pow<2>(x)
+    template <int P, typename U, typename T, typename E>
+    auto pow(const Quantity<U, T, E> &x) {
+        if constexpr (P < 0) {
+            return Quantity<UnitQuotient<One, typename UnitPower<U, -P>::type>, T, E>(narrow<T, E>(
+                    ::pow(x.errorValue(), P)));
+        } else {
+            return Quantity<typename UnitPower<U, P>::type, T, E>(narrow<T, E>(::pow(x.errorValue(), P)));
+        }
+    }
+
+    template <typename U, typename T, typename E>
+    Quantity<U, T, E> abs(const Quantity<U, T, E> &x) {
+        return Quantity<U, T, E>(narrow<T, E>(::abs(x.errorValue())));
+    }
+
+    template <typename U1, typename U2, typename T, typename E>
+    Quantity<CommonUnit<U1, U2>, T, E> hypot(const Quantity<U1, T, E> &a, const Quantity<U2, T, E> &b) {
+        static_assert(std::is_same<typename U1::dimension, typename U2::dimension>::value,
+                      "Arguments of hypot must have the same dimension");
+        using C = CommonUnit<U1, U2>;
+        return Quantity<C, T, E>(narrow<T, E>(::hypot(errorValueIn<C>(a), errorValueIn<C>(b))));
+    }
+
+    template <typename U1, typename U2, typename T, typename E>
+    Quantity<One, T, E> atan2(const Quantity<U1, T, E> &y, const Quantity<U2, T, E> &x) {
+        static_assert(std::is_same<typename U1::dimension, typename U2::dimension>::value,
+                      "Arguments of atan2 must have the same dimension");
+        using C = CommonUnit<U1, U2>;
+        return Quantity<One, T, E>(narrow<T, E>(::atan2(errorValueIn<C>(y), errorValueIn<C>(x))));
+    }
+
+    // a*b + c in the unit of a*b
+    template <typename U1, typename U2, typename U3, typename T, typename E>
+    Quantity<UnitProduct<U1, U2>, T, E> fma(const Quantity<U1, T, E> &a, const Quantity<U2, T, E> &b,
+                                            const Quantity<U3, T, E> &c) {
+        using P = Quantity<UnitProduct<U1, U2>, T, E>;
+        static_assert(std::is_same<typename P::dimension, typename U3::dimension>::value,
+                      "Addend of fma must have the dimension of the product");
+        return P(narrow<T, E>(::fma(a.errorValue(), b.errorValue(), errorValueIn<UnitProduct<U1, U2>>(c))));
+    }
+
+    // Transcendental functions take dimensionless arguments, angles are in radians
+#define LIBERRC_UNITS_DIMENSIONLESS(f) \
+    template <typename U, typename T, typename E> \
+    Quantity<One, T, E> f(const Quantity<U, T, E> &x) { \
+        static_assert(std::is_same<typename U::dimension, Dimensionless>::value, \
+                      "Argument of " #f " must be dimensionless"); \
+        return Quantity<One, T, E>(narrow<T, E>(::f(errorValueIn<One>(x)))); \
+    }
+
+    LIBERRC_UNITS_DIMENSIONLESS(sin)
+    LIBERRC_UNITS_DIMENSIONLESS(cos)
+    LIBERRC_UNITS_DIMENSIONLESS(tan)
+    LIBERRC_UNITS_DIMENSIONLESS(asin)
+    LIBERRC_UNITS_DIMENSIONLESS(acos)
+    LIBERRC_UNITS_DIMENSIONLESS(atan)
+    LIBERRC_UNITS_DIMENSIONLESS(sinh)
+    LIBERRC_UNITS_DIMENSIONLESS(cosh)
+    LIBERRC_UNITS_DIMENSIONLESS(tanh)
+    LIBERRC_UNITS_DIMENSIONLESS(asinh)
+    LIBERRC_UNITS_DIMENSIONLESS(acosh)
+    LIBERRC_UNITS_DIMENSIONLESS(atanh)
+    LIBERRC_UNITS_DIMENSIONLESS(exp)
+    LIBERRC_UNITS_DIMENSIONLESS(exp2)
+    LIBERRC_UNITS_DIMENSIONLESS(expm1)
+    LIBERRC_UNITS_DIMENSIONLESS(log)
+    LIBERRC_UNITS_DIMENSIONLESS(log2)
+    LIBERRC_UNITS_DIMENSIONLESS(log10)
+    LIBERRC_UNITS_DIMENSIONLESS(log1p)
+    LIBERRC_UNITS_DIMENSIONLESS(erf)
+    LIBERRC_UNITS_DIMENSIONLESS(erfc)
+
+#undef LIBERRC_UNITS_DIMENSIONLESS
+
+#endif
+
+    //------- LAYOUT -------
+
+    static_assert(sizeof(Quantity<Metre, double>) == sizeof(ErrorValue<double, double>) &&
+                  alignof(Quantity<Metre, double>) == alignof(ErrorValue<double, double>),
+                  "Quantity must have the layout of ErrorValue");
+    static_assert(sizeof(Quantity<Kilometre, float>) == sizeof(ErrorValue<float, float>) &&
+                  alignof(Quantity<Kilometre, float>) == alignof(ErrorValue<float, float>),
+                  "Quantity must have the layout of ErrorValue");
+    static_assert(sizeof(Quantity<Newton, long double>) == sizeof(ErrorValue<long double, long double>),
+                  "Quantity must have the layout of ErrorValue");
+
+}
+
+#endif //LIBERRC_ERRC_UNITS_H
@@ -0,0 +1,150 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_ALLOC_COUNTER_H
+#define LIBERRC_ALLOC_COUNTER_H
+
+// Replaces global operator new/delete with counting versions. Include it in exactly one source file of a target.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+inline std::atomic<std::size_t> allocationCount{0};
+
+inline std::size_t allocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+// Every form below goes through these two. The replacements stay out of line, so callers see operator new paired
+// with operator delete and never a free() of memory from operator new (-Wmismatched-new-delete).
+#if defined(__GNUC__) || defined(__clang__)
+#define LIBERRC_ALLOC_NOINLINE __attribute__((noinline))
+#else
+#define LIBERRC_ALLOC_NOINLINE
+#endif
+
+inline void* countedAllocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) noexcept {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0)
+        size = 1;
+    if (alignment <= alignof(std::max_align_t))
+        return std::malloc(size);
+    return std::aligned_alloc(alignment, (size + alignment - 1)/alignment*alignment);
+}
+
+inline void countedRelease(void* p) noexcept {
+    std::free(p);
+}
+
+inline void* countedAllocateOrThrow(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+    if (void* p = countedAllocate(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+
+//------- NEW -------
+
+LIBERRC_ALLOC_NOINLINE void* operator new(std::size_t size) {
+    return countedAllocateOrThrow(size);
+}
+
+LIBERRC_ALLOC_NOINLINE void* operator new[](std::size_t size) {
+    return countedAllocateOrThrow(size);
+}
+
+LIBERRC_ALLOC_NOINLINE void* operator new(std::size_t size, std::align_val_t alignment) {
+    return countedAllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+LIBERRC_ALLOC_NOINLINE void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return countedAllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+LIBERRC_ALLOC_NOINLINE void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+LIBERRC_ALLOC_NOINLINE void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+LIBERRC_ALLOC_NOINLINE void* operator new(std::size_t size, std::align_val_t alignment,
+                                          const std::nothrow_t&) noexcept {
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+LIBERRC_ALLOC_NOINLINE void* operator new[](std::size_t size, std::align_val_t alignment,
+                                            const std::nothrow_t&) noexcept {
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+//------- DELETE -------
+
+LIBERRC_ALLOC_NOINLINE void operator delete(void* p) noexcept {
+    countedRelease(p);
+}
+
+LIBERRC_ALLOC_NOINLINE void operator delete[](void* p) noexcept {
+    countedRelease(p);
+}
+
+LIBERRC_ALLOC_NOINLINE void operator delete(void* p, std::size_t) noexcept {
+    countedRelease(p);
+}
+
+LIBERRC_ALLOC_NOINLINE void operator delete[](void* p, std::size_t) noexcept {
+    countedRelease(p);
+}
+
+LIBERRC_ALLOC_NOINLINE void operator delete(void* p, std::align_val_t) noexcept {
+    countedRelease(p);
+}
+
+LIBERRC_ALLOC_NOINLINE void operator delete[](void* p, std::align_val_t) noexcept {
+    countedRelease(p);
+}
+
+LIBERRC_ALLOC_NOINLINE void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    countedRelease(p);
+}
+
+LIBERRC_ALLOC_NOINLINE void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    countedRelease(p);
+}
+
+LIBERRC_ALLOC_NOINLINE void operator delete(void* p, const std::nothrow_t&) noexcept {
+    countedRelease(p);
+}
+
+LIBERRC_ALLOC_NOINLINE void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    countedRelease(p);
+}
+
+LIBERRC_ALLOC_NOINLINE void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    countedRelease(p);
+}
+
+LIBERRC_ALLOC_NOINLINE void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    countedRelease(p);
+}
+
+#undef LIBERRC_ALLOC_NOINLINE
+
+#endif //LIBERRC_ALLOC_COUNTER_H
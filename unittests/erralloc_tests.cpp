@@ -0,0 +1,103 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+
+#include "gtest/gtest.h"
+
+#include "alloc_counter.h"
+#include "errc.h"
+
+using EV = ErrorValue<double, double>;
+
+static_assert(std::is_same<decltype(std::declval<EV&>() += std::declval<EV>()), EV&>::value,
+              "Compound assignment must return a reference");
+static_assert(std::is_nothrow_move_constructible<EV>::value, "ErrorValue must be nothrow movable");
+
+// Runs f and returns how many times operator new was called
+template <typename F>
+std::size_t countAllocations(F f) {
+    std::size_t before = allocations();
+    f();
+    return allocations() - before;
+}
+
+void installHeavyFunction(EV &ev) {
+    std::array<double, 16> table{};
+    table[0] = 0.25;
+    ev.setDefaultErrorCalculationMethod(EV::DEF_ERROR_FUNC, [table](double) { return table[0]; });
+}
+
+TEST(ErrorValueAllocationTests, Arithmetic) {
+    EV a(1.5, 0.1), b(2.5, 0.2);
+    ASSERT_EQ(countAllocations([&] {
+        EV r = a + b;
+        r = a - b;
+        r = a * b;
+        r = a / b;
+        r = a + 2.0;
+        r = (a - 2.0) * 3.0 / 4.0;
+        r = a + b - a * b / b;
+        r += a, r -= b, r *= a, r /= b;
+        r += 1.0, r -= 1.0, r *= 2.0, r /= 2.0;
+        r = -r;
+        r = +r;
+        ++r, r++, --r, r--;
+        r = 7.0;
+    }), 0);
+}
+
+TEST(ErrorValueAllocationTests, ArithmeticWithCustomDefaultError) {
+    EV a(1.5, 0.1), b(2.5, 0.2);
+    installHeavyFunction(a);
+    ASSERT_EQ(countAllocations([&] {
+        EV c = a, d = a;
+        EV r = a + b;
+        r = a * 2.0 + b;
+        r = std::move(d) - 1.0;
+        c = 4.0;
+        r += c;
+    }), 0);
+    EV c = a;
+    c = 4.0;
+    ASSERT_EQ(c.error, 0.25);
+}
+
+TEST(ErrorValueAllocationTests, Comparison) {
+    EV a(1.5, 0.1), b(2.5, 0.2), c(1.5, 0.3);
+    bool res = false;
+    ASSERT_EQ(countAllocations([&] {
+        res = (a < b) && (a <= b) && !(a > b) && !(a >= b) && (a != b) && (a == c) && !(a == b);
+    }), 0);
+    ASSERT_TRUE(res);
+}
+
+TEST(ErrorValueAllocationTests, Errmath) {
+    EV x(0.5, 0.01), y(1.5, 0.02), z(2.0, 0.03);
+    ASSERT_EQ(countAllocations([&] {
+        EV r = sin(x) + cos(x) + tan(x) + asin(x) + acos(x) + atan(x) + atan2(x, y);
+        r = sinh(x) + cosh(x) + tanh(x) + asinh(y) + acosh(y) + atanh(x);
+        r = erf(x) + erfc(x) + exp(x) + log10(x) + exp2(x) + log2(x) + log(x) + expm1(x) + log1p(x);
+        r = logn(y, 3) + pow(x, y) + pow(x, 3) + sqrt(x) + cbrt(x) + hypot(x, y) + abs(x) + fma(x, y, z);
+    }), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
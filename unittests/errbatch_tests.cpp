@@ -0,0 +1,136 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include "errc_batch.h"
+
+using liberrc::ErrorArray;
+using liberrc::simd::Isa;
+
+const double ABSMAX = 0.000001;
+const std::size_t N = 37;
+
+std::vector<Isa> supportedIsas() {
+    std::vector<Isa> res;
+    for (Isa isa : {Isa::SCALAR, Isa::SSE2, Isa::AVX2, Isa::AVX512})
+        if (isa <= liberrc::simd::detectIsa())
+            res.push_back(isa);
+    return res;
+}
+
+template <typename T>
+ErrorArray<T> makeArray(T offset) {
+    ErrorArray<T> a(N);
+    for (std::size_t i = 0; i < N; ++i)
+        a.set(i, offset + static_cast<T>(i)/4, static_cast<T>(0.01) + static_cast<T>(i)/100);
+    return a;
+}
+
+TEST(IsaDispatchTests, IsaNames) {
+    Isa isa;
+    ASSERT_TRUE(liberrc::simd::parseIsa("avx2", isa));
+    ASSERT_EQ(isa, Isa::AVX2);
+    ASSERT_FALSE(liberrc::simd::parseIsa("neon", isa));
+    ASSERT_STREQ(liberrc::simd::isaName(Isa::AVX512), "avx512");
+}
+
+TEST(IsaDispatchTests, ActiveIsaIsSupported) {
+    ASSERT_LE(liberrc::simd::activeIsa(), liberrc::simd::detectIsa());
+    ASSERT_EQ(liberrc::batch::kernels<double>().isa, liberrc::simd::activeIsa());
+    for (Isa isa : supportedIsas())
+        ASSERT_EQ(liberrc::batch::kernels<float>(isa).isa, isa);
+}
+
+TEST(BatchArithmeticTests, MatchesErrorValue) {
+    ErrorArray<double> a = makeArray(1.5), b = makeArray(-4.1);
+    ErrorArray<double> r(N);
+    for (Isa isa : supportedIsas()) {
+        const liberrc::batch::Kernels<double> &k = liberrc::batch::kernels<double>(isa);
+        for (auto [kernel, op] : {std::pair{k.add, 0}, {k.sub, 1}, {k.mul, 2}, {k.div, 3}}) {
+            kernel(a.value.data(), a.error.data(), b.value.data(), b.error.data(),
+                   r.value.data(), r.error.data(), N);
+            for (std::size_t i = 0; i < N; ++i) {
+                ErrorValue<double, double> x = a[i], y = b[i];
+                ErrorValue<double, double> e = op == 0 ? x + y : op == 1 ? x - y : op == 2 ? x * y : x / y;
+                ASSERT_NEAR(r.value[i], e.value, ABSMAX) << liberrc::simd::isaName(isa) << " op " << op;
+                ASSERT_NEAR(r.error[i], std::abs(e.error), ABSMAX) << liberrc::simd::isaName(isa) << " op " << op;
+            }
+        }
+    }
+}
+
+TEST(BatchArithmeticTests, FloatOperatorsAndAliasing) {
+    ErrorArray<float> a = makeArray(2.0f), b = makeArray(3.0f);
+    ErrorArray<float> r = a + b;
+    for (Isa isa : supportedIsas()) {
+        ErrorArray<float> c = a;
+        liberrc::batch::kernels<float>(isa).add(c.value.data(), c.error.data(), b.value.data(), b.error.data(),
+                                                c.value.data(), c.error.data(), N);
+        for (std::size_t i = 0; i < N; ++i) {
+            ASSERT_NEAR(c.value[i], r.value[i], 1e-4);
+            ASSERT_NEAR(c.error[i], r.error[i], 1e-4);
+        }
+    }
+    ASSERT_THROW(a + ErrorArray<float>(3), std::invalid_argument);
+}
+
+TEST(BatchErrmathTests, MatchesErrorValue) {
+    ErrorArray<double> x = makeArray(0.25);
+    ErrorArray<double> r(N);
+    for (Isa isa : supportedIsas()) {
+        const liberrc::batch::Kernels<double> &k = liberrc::batch::kernels<double>(isa);
+        for (auto [kernel, fn] : {std::pair{k.sqrt, 0}, {k.exp, 1}, {k.log, 2}, {k.sin, 3}, {k.cos, 4}}) {
+            kernel(x.value.data(), x.error.data(), r.value.data(), r.error.data(), N);
+            for (std::size_t i = 0; i < N; ++i) {
+                ErrorValue<double, double> v = x[i];
+                ErrorValue<double, double> e = fn == 0 ? sqrt(v) : fn == 1 ? exp(v) : fn == 2 ? log(v)
+                        : fn == 3 ? sin(v) : cos(v);
+                ASSERT_NEAR(r.value[i], e.value, ABSMAX) << liberrc::simd::isaName(isa) << " fn " << fn;
+                ASSERT_NEAR(r.error[i], e.error, ABSMAX) << liberrc::simd::isaName(isa) << " fn " << fn;
+            }
+        }
+    }
+}
+
+TEST(BatchReductionTests, SumAndWeightedMean) {
+    ErrorArray<double> x = makeArray(1.0);
+    ErrorValue<double, double> expectedSum = x[0];
+    double sw = 0, swx = 0;
+    for (std::size_t i = 0; i < N; ++i) {
+        if (i > 0)
+            expectedSum += x[i];
+        double w = 1/(x.error[i]*x.error[i]);
+        sw += w;
+        swx += w*x.value[i];
+    }
+    for (Isa isa : supportedIsas()) {
+        const liberrc::batch::Kernels<double> &k = liberrc::batch::kernels<double>(isa);
+        ErrorValue<double, double> s = k.sum(x.value.data(), x.error.data(), N);
+        ASSERT_NEAR(s.value, expectedSum.value, ABSMAX);
+        ASSERT_NEAR(s.error, expectedSum.error, ABSMAX);
+        ErrorValue<double, double> m = k.weightedMean(x.value.data(), x.error.data(), N);
+        ASSERT_NEAR(m.value, swx/sw, ABSMAX);
+        ASSERT_NEAR(m.error, 1/std::sqrt(sw), ABSMAX);
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
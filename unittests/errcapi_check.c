@@ -0,0 +1,31 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+/* Compiled as C, so the tests fail to build if errc_capi.h stops being a C header */
+
+#include "errc_capi.h"
+
+int liberrc_c_check(void) {
+    const double v[3] = {1.0, 2.0, 3.0}, e[3] = {0.1, 0.2, 0.2};
+    double sv, se;
+    if (liberrc_abi_version() != LIBERRC_ABI_VERSION)
+        return 1;
+    if (liberrc_sum_f64(v, e, 3, &sv, &se) != LIBERRC_OK)
+        return 2;
+    return sv == 6.0 && se > 0.29 && se < 0.31 ? 0 : 3;
+}
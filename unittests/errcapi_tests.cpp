@@ -0,0 +1,141 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include <climits>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "errc_batch.h"
+#include "errc_capi.h"
+
+using liberrc::ErrorArray;
+
+extern "C" int liberrc_c_check(void);
+
+const double ABSMAX = 0.000001;
+
+template <typename T>
+ErrorArray<T> makeArray(std::size_t n, T offset) {
+    ErrorArray<T> x(n);
+    for (std::size_t i = 0; i < n; ++i)
+        x.set(i, offset + static_cast<T>(0.37*i), static_cast<T>(0.01 + 0.002*(i%7)));
+    return x;
+}
+
+TEST(CApiTests, Version) {
+    ASSERT_EQ(liberrc_abi_version(), LIBERRC_ABI_VERSION);
+    ASSERT_STREQ(liberrc_isa_name(), liberrc::simd::isaName(liberrc::simd::activeIsa()));
+    ASSERT_EQ(liberrc_c_check(), 0);
+}
+
+TEST(CApiTests, ArithmeticMatchesErrorArray) {
+    ErrorArray<double> a = makeArray(101, 1.0), b = makeArray(101, 2.5);
+    ErrorArray<double> r(a.size());
+    ASSERT_EQ(liberrc_div_f64(a.value.data(), a.error.data(), b.value.data(), b.error.data(),
+                              r.value.data(), r.error.data(), a.size()), LIBERRC_OK);
+    ErrorArray<double> expected = a/b;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        ASSERT_NEAR(r.value[i], expected.value[i], ABSMAX);
+        ASSERT_NEAR(r.error[i], expected.error[i], ABSMAX);
+    }
+
+    // In place, output aliases the first input
+    ErrorArray<float> x = makeArray(37, 1.0f), y = makeArray(37, 0.5f);
+    ErrorArray<float> sum = x + y;
+    ASSERT_EQ(liberrc_add_f32(x.value.data(), x.error.data(), y.value.data(), y.error.data(),
+                              x.value.data(), x.error.data(), x.size()), LIBERRC_OK);
+    ASSERT_EQ(x.value, sum.value);
+    ASSERT_EQ(x.error, sum.error);
+}
+
+TEST(CApiTests, ErrmathAndReductions) {
+    ErrorArray<double> x = makeArray(64, 0.5);
+    ErrorArray<double> r(x.size());
+    ASSERT_EQ(liberrc_log_f64(x.value.data(), x.error.data(), r.value.data(), r.error.data(), x.size()), LIBERRC_OK);
+    ErrorArray<double> expected = log(x);
+    ASSERT_EQ(r.value, expected.value);
+    ASSERT_EQ(r.error, expected.error);
+
+    double v, e;
+    ASSERT_EQ(liberrc_weighted_mean_f64(x.value.data(), x.error.data(), x.size(), &v, &e), LIBERRC_OK);
+    ErrorValue<double, double> mean = weightedMean(x);
+    ASSERT_NEAR(v, mean.value, ABSMAX);
+    ASSERT_NEAR(e, mean.error, ABSMAX);
+
+    float fv, fe;
+    ErrorArray<float> f = makeArray(10, 1.0f);
+    ASSERT_EQ(liberrc_sum_f32(f.value.data(), f.error.data(), f.size(), &fv, &fe), LIBERRC_OK);
+    ASSERT_NEAR(fv, sum(f).value, 1e-4);
+}
+
+TEST(CApiTests, NullPointers) {
+    double v = 1, e = 0.1;
+    ASSERT_EQ(liberrc_sqrt_f64(&v, nullptr, &v, &e, 1), LIBERRC_ERROR_NULL_POINTER);
+    ASSERT_EQ(liberrc_mul_f32(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 0), LIBERRC_OK);
+    ASSERT_EQ(liberrc_sum_f64(&v, &e, 1, nullptr, &e), LIBERRC_ERROR_NULL_POINTER);
+}
+
+TEST(CApiTests, Format) {
+    const double v[2] = {1.5, -20.25}, e[2] = {0.125, 3.0};
+    std::ostringstream stream;
+    stream << ErrorValue(v[0], e[0]) << "\n" << ErrorValue(v[1], e[1]);
+
+    size_t length = 0;
+    ASSERT_EQ(liberrc_format_f64(v, e, 2, -1, nullptr, 0, &length), LIBERRC_OK);
+    ASSERT_EQ(length, stream.str().size());
+    std::string out(length + 1, 'x');
+    ASSERT_EQ(liberrc_format_f64(v, e, 2, -1, &out[0], out.size(), &length), LIBERRC_OK);
+    ASSERT_EQ(out.c_str(), stream.str());
+
+    char small[8];
+    ASSERT_EQ(liberrc_format_f64(v, e, 2, 2, small, sizeof(small), &length), LIBERRC_ERROR_BUFFER_TOO_SMALL);
+    ASSERT_STREQ(small, "1.50 \xc2\xb1");
+
+    const float f[1] = {2.0f}, fe[1] = {0.5f};
+    char one[32];
+    ASSERT_EQ(liberrc_format_f32(f, fe, 1, 1, one, sizeof(one), &length), LIBERRC_OK);
+    ASSERT_STREQ(one, "2.0 \xc2\xb1 0.5");
+
+    // Capacity 0 is a pure length query and leaves out alone
+    char untouched = 'x';
+    ASSERT_EQ(liberrc_format_f64(v, e, 2, -1, &untouched, 0, &length), LIBERRC_OK);
+    ASSERT_EQ(untouched, 'x');
+    ASSERT_EQ(length, stream.str().size());
+    ASSERT_EQ(liberrc_format_f32(f, fe, 0, -1, nullptr, 0, &length), LIBERRC_OK);
+    ASSERT_EQ(length, 0u);
+
+    // A precision snprintf can not honour is clamped instead of wrapping the length
+    size_t clamped = 0;
+    ASSERT_EQ(liberrc_format_f64(v, e, 2, LIBERRC_MAX_PRECISION, nullptr, 0, &clamped), LIBERRC_OK);
+    ASSERT_EQ(liberrc_format_f64(v, e, 2, INT_MAX, nullptr, 0, &length), LIBERRC_OK);
+    ASSERT_EQ(length, clamped);
+    std::string huge(length + 1, 'x');
+    ASSERT_EQ(liberrc_format_f64(v, e, 2, INT_MAX, &huge[0], huge.size(), &length), LIBERRC_OK);
+    std::ostringstream wide;
+    wide << std::fixed << std::setprecision(LIBERRC_MAX_PRECISION)
+         << v[0] << " \xc2\xb1 " << e[0] << "\n" << v[1] << " \xc2\xb1 " << e[1];
+    ASSERT_EQ(huge.c_str(), wide.str());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,132 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <limits>
+
+#include "gtest/gtest.h"
+
+#include "errc_compare.h"
+#include "test_data.h"
+
+namespace compare = liberrc::compare;
+using liberrc::Bitmask;
+using liberrc::ErrorArray;
+using liberrc::simd::Isa;
+
+template <typename T>
+ErrorArray<T> makeArray(std::size_t n, std::size_t seed) {
+    return generateArray<T>(n, [seed](std::size_t i) {
+        return ErrorValue(3*noise(i + seed), 0.5 + noise(2*i + seed + 1));
+    });
+}
+
+bool reference(compare::Test test, double a, double ea, double b, double eb, double k) {
+    double band = k*std::sqrt(ea*ea + eb*eb);
+    if (test == compare::Test::CONSISTENT)
+        return std::abs(a - b) <= band;
+    return test == compare::Test::GREATER ? a - b > band : b - a > band;
+}
+
+template <typename T>
+void checkKernels() {
+    // Sizes around word and pack boundaries
+    for (std::size_t n : {0, 1, 7, 63, 64, 65, 200, 1003}) {
+        ErrorArray<T> a = makeArray<T>(n, 0), b = makeArray<T>(n, 31);
+        const ErrorValue<T, T> s(static_cast<T>(0.2), static_cast<T>(0.3));
+        for (Isa isa : {Isa::SCALAR, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+            if (isa > liberrc::simd::detectIsa())
+                continue;
+            const compare::Kernels<T> &kernels = compare::kernels<T>(isa);
+            for (compare::Test test : {compare::Test::CONSISTENT, compare::Test::GREATER, compare::Test::LESS}) {
+                Bitmask arrays = compare::apply(test, a, b, static_cast<T>(1.5), kernels);
+                Bitmask scalars = compare::apply(test, a, s, static_cast<T>(1.5), kernels);
+                ASSERT_EQ(arrays.size(), n);
+                for (std::size_t i = 0; i < n; ++i) {
+                    ASSERT_EQ(arrays[i], reference(test, a.value[i], a.error[i], b.value[i], b.error[i], 1.5))
+                        << "isa " << liberrc::simd::isaName(isa) << " element " << i;
+                    ASSERT_EQ(scalars[i], reference(test, a.value[i], a.error[i], s.value, s.error, 1.5))
+                        << "isa " << liberrc::simd::isaName(isa) << " element " << i;
+                }
+                if (n%64 != 0) {
+                    ASSERT_EQ(arrays.words.back() >> (n%64), 0u);
+                }
+            }
+        }
+    }
+}
+
+TEST(CompareTests, KernelsMatchReference) {
+    checkKernels<double>();
+    checkKernels<float>();
+}
+
+TEST(CompareTests, ScalarComparisons) {
+    ErrorValue a(10.0, 0.3), b(10.5, 0.4);
+    ASSERT_TRUE(liberrc::consistent(a, b));
+    ASSERT_FALSE(liberrc::consistent(a, b, 0.5));
+    ASSERT_TRUE(liberrc::significantlyLess(a, b, 0.5));
+    ASSERT_FALSE(liberrc::significantlyGreater(a, b, 0.5));
+    ASSERT_TRUE(liberrc::significantlyGreater(b, a, 0.5));
+}
+
+TEST(CompareTests, NaNFailsEveryTest) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    ErrorArray<double> a = {ErrorValue(1.0, 0.1), ErrorValue(nan, 0.1), ErrorValue(1.0, nan)};
+    ErrorValue<double, double> b(1.0, 0.1);
+    ASSERT_EQ(liberrc::consistent(a, b).indices(), std::vector<std::size_t>{0});
+    ASSERT_TRUE(liberrc::significantlyGreater(a, b).none());
+    ASSERT_TRUE(liberrc::significantlyLess(a, b).none());
+}
+
+TEST(CompareTests, BitmaskOperations) {
+    Bitmask m(130);
+    ASSERT_TRUE(m.none());
+    for (std::size_t i : {0, 5, 63, 64, 100, 129})
+        m.set(i);
+    ASSERT_EQ(m.count(), 6u);
+    ASSERT_EQ((~m).count(), 124u);
+    ASSERT_EQ((m & ~m).count(), 0u);
+    ASSERT_TRUE((m | ~m).all());
+    ASSERT_EQ(m.indices(), (std::vector<std::size_t>{0, 5, 63, 64, 100, 129}));
+    m.set(5, false);
+    ASSERT_FALSE(m[5]);
+    ASSERT_EQ(Bitmask(70, true).count(), 70u);
+    ASSERT_THROW(m &= Bitmask(129), std::invalid_argument);
+}
+
+TEST(CompareTests, Compact) {
+    ErrorArray<float> x = makeArray<float>(1000, 3);
+    Bitmask keep = liberrc::consistent(x, ErrorValue<float, float>(0.0f, 0.5f), 2);
+    for (std::size_t i = 128; i < 192; ++i)
+        keep.set(i);
+    ErrorArray<float> kept = liberrc::compact(x, keep);
+    std::vector<std::size_t> where = keep.indices();
+    ASSERT_EQ(kept.size(), keep.count());
+    ASSERT_EQ(where.size(), kept.size());
+    for (std::size_t j = 0; j < where.size(); ++j) {
+        ASSERT_EQ(kept.value[j], x.value[where[j]]);
+        ASSERT_EQ(kept.error[j], x.error[where[j]]);
+    }
+    ASSERT_THROW((void)liberrc::compact(std::vector<int>(3), keep), std::invalid_argument);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,130 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include "errc_complex.h"
+
+using liberrc::ComplexErrorValue;
+using liberrc::ComplexErrorArray;
+using liberrc::simd::Isa;
+using CEV = ComplexErrorValue<double>;
+
+const double ABSMAX = 0.000001;
+const std::size_t N = 37;
+
+void assertNear(const CEV &a, const CEV &b) {
+    ASSERT_NEAR(a.value.real(), b.value.real(), ABSMAX);
+    ASSERT_NEAR(a.value.imag(), b.value.imag(), ABSMAX);
+    ASSERT_NEAR(a.varRe, b.varRe, ABSMAX);
+    ASSERT_NEAR(a.varIm, b.varIm, ABSMAX);
+    ASSERT_NEAR(a.covReIm, b.covReIm, ABSMAX);
+}
+
+TEST(ComplexErrorValueTests, Construction) {
+    CEV z(ErrorValue(3.0, 0.1), ErrorValue(4.0, 0.2));
+    ASSERT_NEAR(z.real().error, 0.1, ABSMAX);
+    ASSERT_NEAR(z.imag().value, 4.0, ABSMAX);
+    ASSERT_NEAR(z.imag().error, 0.2, ABSMAX);
+    ASSERT_EQ(z.covReIm, 0);
+}
+
+TEST(ComplexErrorValueTests, AddAndSub) {
+    CEV a = CEV::fromCovariance({1, 2}, 0.01, 0.04, 0.005), b({3, -1}, 0.3, 0.1);
+    assertNear(a + b, CEV::fromCovariance({4, 1}, 0.1, 0.05, 0.005));
+    assertNear(a - b, CEV::fromCovariance({-2, 3}, 0.1, 0.05, 0.005));
+}
+
+TEST(ComplexErrorValueTests, MultiplyByExactImaginaryUnitRotates) {
+    CEV a = CEV::fromCovariance({1, 2}, 0.01, 0.04, 0.005), i({0, 1}, 0, 0);
+    assertNear(a*i, CEV::fromCovariance({-2, 1}, 0.04, 0.01, -0.005));
+    assertNear((a*i)/i, a);
+}
+
+TEST(ComplexErrorValueTests, MulMatchesRealProduct) {
+    // Real operands: the product error must match ErrorValue multiplication
+    CEV a({2, 0}, 0.1, 0), b({3, 0}, 0.2, 0);
+    ErrorValue<double, double> e = ErrorValue(2.0, 0.1)*ErrorValue(3.0, 0.2);
+    ASSERT_NEAR((a*b).real().error, e.error, ABSMAX);
+    ASSERT_NEAR((a/b).real().error, (ErrorValue(2.0, 0.1)/ErrorValue(3.0, 0.2)).error, ABSMAX);
+}
+
+TEST(ComplexErrmathTests, AbsAndArg) {
+    CEV z(ErrorValue(3.0, 0.1), ErrorValue(4.0, 0.2));
+    ErrorValue<double, double> r = abs(z), t = arg(z);
+    ASSERT_NEAR(r.value, 5, ABSMAX);
+    ASSERT_NEAR(r.error, std::hypot(0.6*0.1, 0.8*0.2), ABSMAX);
+    ASSERT_NEAR(t.value, std::atan2(4.0, 3.0), ABSMAX);
+    ASSERT_NEAR(t.error, std::hypot(4*0.1, 3*0.2)/25, ABSMAX);
+}
+
+TEST(ComplexErrmathTests, PolarRoundTrip) {
+    ErrorValue<double, double> r(2.0, 0.05), t(0.7, 0.01);
+    CEV z = liberrc::polar(r, t);
+    ASSERT_NEAR(abs(z).error, 0.05, ABSMAX);
+    ASSERT_NEAR(arg(z).error, 0.01, ABSMAX);
+    ASSERT_NEAR(arg(z).value, 0.7, ABSMAX);
+}
+
+TEST(ComplexErrmathTests, ExpLogRoundTrip) {
+    CEV z = CEV::fromCovariance({0.3, -1.2}, 0.01, 0.04, 0.005);
+    assertNear(log(exp(z)), z);
+    ErrorValue<double, double> x(0.3, 0.1);
+    ASSERT_NEAR(exp(CEV({0.3, 0}, 0.1, 0)).real().error, exp(x).error, ABSMAX);
+}
+
+TEST(ComplexErrorArrayTests, KernelsMatchScalar) {
+    ComplexErrorArray<double> a(N), b(N), acc(N);
+    for (std::size_t i = 0; i < N; ++i) {
+        a.set(i, CEV::fromCovariance({1.0 + i, 2.0 - i}, 0.01*i, 0.02, 0.001*i));
+        b.set(i, CEV::fromCovariance({0.5, -0.25*i}, 0.03, 0.01*i, -0.002));
+        acc.set(i, CEV({0.1*i, 1.0}, 0.1, 0.1));
+    }
+    for (Isa isa : {Isa::SCALAR, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+        if (isa > liberrc::simd::detectIsa())
+            continue;
+        const liberrc::batch::ComplexKernels<double> &k = liberrc::batch::complexKernels<double>(isa);
+        ComplexErrorArray<double> sum(N), prod(N), mac = acc;
+        k.add(a.raw(), b.raw(), sum.raw(), a.blocks());
+        k.mul(a.raw(), b.raw(), prod.raw(), a.blocks());
+        k.multiplyAccumulate(mac.raw(), a.raw(), b.raw(), a.blocks());
+        for (std::size_t i = 0; i < N; ++i) {
+            assertNear(sum[i], a[i] + b[i]);
+            assertNear(prod[i], a[i]*b[i]);
+            assertNear(mac[i], acc[i] + a[i]*b[i]);
+        }
+    }
+    ASSERT_THROW(a*ComplexErrorArray<double>(2), std::invalid_argument);
+}
+
+TEST(ComplexErrorArrayTests, FloatOperators) {
+    ComplexErrorArray<float> a(20), b(20);
+    for (std::size_t i = 0; i < 20; ++i) {
+        a.set(i, ComplexErrorValue<float>({1.0f, 0.5f*i}, 0.1f, 0.2f));
+        b.set(i, ComplexErrorValue<float>({0.5f*i, -1.0f}, 0.3f, 0.1f));
+    }
+    ComplexErrorArray<float> p = a*b;
+    ComplexErrorValue<float> e = a[19]*b[19];
+    ASSERT_NEAR(p[19].varRe, e.varRe, 1e-3);
+    ASSERT_NEAR(p[19].value.imag(), e.value.imag(), 1e-4);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,147 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include "errc_covariance.h"
+
+using liberrc::Dual;
+using liberrc::ErrorVector;
+using liberrc::ErrorVectorArray;
+using liberrc::Matrix;
+using liberrc::simd::Isa;
+
+const double ABSMAX = 0.000001;
+const std::size_t N = 37;
+
+auto toCartesian = [](const auto &x) {
+    using std::cos, std::sin;
+    return std::array{x[0]*cos(x[1]), x[0]*sin(x[1])};
+};
+
+auto spherical = [](const auto &x) {
+    using std::sqrt, std::atan2;
+    return std::array{sqrt(x[0]*x[0] + x[1]*x[1] + x[2]*x[2]), atan2(x[1], x[0])};
+};
+
+template <std::size_t M>
+void assertNear(const ErrorVector<double, M> &a, const ErrorVector<double, M> &b) {
+    for (std::size_t i = 0; i < M; ++i) {
+        ASSERT_NEAR(a.value[i], b.value[i], ABSMAX);
+        for (std::size_t j = 0; j < M; ++j)
+            ASSERT_NEAR(a.covariance[i][j], b.covariance[i][j], ABSMAX);
+    }
+}
+
+TEST(DualTests, Arithmetic) {
+    Dual<double, 2> x(3.0, 0), y(2.0, 1);
+    Dual<double, 2> f = (x*y + 1)/(x - y) - 2*x;
+    // f = (xy + 1)/(x - y) - 2x
+    ASSERT_NEAR(f.value, 1.0, ABSMAX);
+    ASSERT_NEAR(f.grad[0], (2.0*1.0 - 7.0)/1.0 - 2.0, ABSMAX);
+    ASSERT_NEAR(f.grad[1], (3.0*1.0 + 7.0)/1.0, ABSMAX);
+}
+
+TEST(DualTests, MathFunctions) {
+    Dual<double, 1> x(0.4, 0);
+    ASSERT_NEAR(sin(x).grad[0], std::cos(0.4), ABSMAX);
+    ASSERT_NEAR(acos(x).grad[0], -1/std::sqrt(1 - 0.16), ABSMAX);
+    ASSERT_NEAR(erfc(x).grad[0], -2*std::exp(-0.16)/std::sqrt(M_PI), ABSMAX);
+    ASSERT_NEAR(log1p(x).grad[0], 1/1.4, ABSMAX);
+    ASSERT_NEAR(pow(x, 3.0).grad[0], 3*0.16, ABSMAX);
+    ASSERT_NEAR(pow(2.0, x).grad[0], std::pow(2.0, 0.4)*std::log(2.0), ABSMAX);
+    ASSERT_NEAR(abs(-x).grad[0], 1, ABSMAX);
+
+    Dual<double, 2> y(-1.0, 0), z(0.5, 1);
+    Dual<double, 2> a = atan2(z, y);
+    ASSERT_NEAR(a.value, std::atan2(0.5, -1.0), ABSMAX);
+    ASSERT_NEAR(a.grad[0], -0.5/1.25, ABSMAX);
+    ASSERT_NEAR(a.grad[1], -1.0/1.25, ABSMAX);
+}
+
+TEST(CovarianceTests, PolarToCartesian) {
+    double r = 2.0, t = 0.3, sr = 0.1, st = 0.05;
+    ErrorVector<double, 2> polar(std::array{ErrorValue(r, sr), ErrorValue(t, st)});
+    ErrorVector<double, 2> xy = propagateCovariance(toCartesian, polar);
+
+    double c = std::cos(t), s = std::sin(t);
+    ASSERT_NEAR(xy.value[0], r*c, ABSMAX);
+    ASSERT_NEAR(xy.value[1], r*s, ABSMAX);
+    ASSERT_NEAR(xy.covariance[0][0], c*c*sr*sr + r*r*s*s*st*st, ABSMAX);
+    ASSERT_NEAR(xy.covariance[1][1], s*s*sr*sr + r*r*c*c*st*st, ABSMAX);
+    ASSERT_NEAR(xy.covariance[0][1], c*s*(sr*sr - r*r*st*st), ABSMAX);
+    ASSERT_NEAR(xy.covariance[1][0], xy.covariance[0][1], ABSMAX);
+    ASSERT_NEAR(xy[0].error, std::sqrt(xy.covariance[0][0]), ABSMAX);
+
+    Matrix<double, 2, 2> j = liberrc::jacobian(toCartesian, polar.value);
+    ASSERT_NEAR(j[0][1], -r*s, ABSMAX);
+    ASSERT_NEAR(j[1][1], r*c, ABSMAX);
+}
+
+TEST(CovarianceTests, MatchesErrorValue) {
+    ErrorValue<double, double> a(3.0, 0.2), b(1.5, 0.1);
+    ErrorVector<double, 1> p = propagateCovariance([](const auto &x) { return std::array{x[0]*x[1]}; },
+                                                   ErrorVector<double, 2>(std::array{a, b}));
+    ASSERT_NEAR(p[0].value, (a*b).value, ABSMAX);
+    ASSERT_NEAR(p[0].error, (a*b).error, ABSMAX);
+}
+
+TEST(CovarianceTests, Correlations) {
+    // Fully correlated inputs with equal errors cancel in the difference and add up in the sum
+    ErrorVector<double, 2> x({1.0, 2.0}, {{{0.04, 0.04}, {0.04, 0.04}}});
+    auto f = [](const auto &v) { return std::array{v[0] - v[1], v[0] + v[1]}; };
+    ErrorVector<double, 2> d = propagateCovariance(f, x);
+    ASSERT_NEAR(d.covariance[0][0], 0, ABSMAX);
+    ASSERT_NEAR(d.covariance[1][1], 0.16, ABSMAX);
+    ASSERT_NEAR(d[1].error, 0.4, ABSMAX);
+}
+
+TEST(ErrorVectorArrayTests, KernelsMatchScalar) {
+    ErrorVectorArray<double, 3> x(N);
+    for (std::size_t i = 0; i < N; ++i) {
+        double e = 0.01*(i + 1);
+        x.set(i, ErrorVector<double, 3>({1.0 + i, 0.5 - 0.1*i, 2.0},
+                                        {{{e, 0.1*e, 0}, {0.1*e, 2*e, -0.2*e}, {0, -0.2*e, 0.5*e}}}));
+    }
+    ASSERT_NEAR(x[5].covariance[2][1], -0.012, ABSMAX);
+
+    for (Isa isa : {Isa::SCALAR, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+        if (isa > liberrc::simd::detectIsa())
+            continue;
+        ErrorVectorArray<double, 2> res =
+                propagateCovariance(spherical, x, liberrc::batch::covarianceKernels<double, 3, 2>(isa));
+        ASSERT_EQ(res.size(), N);
+        for (std::size_t i = 0; i < N; ++i)
+            assertNear(res[i], propagateCovariance(spherical, x[i]));
+    }
+}
+
+TEST(ErrorVectorArrayTests, Float) {
+    ErrorVectorArray<float, 2> x(20);
+    for (std::size_t i = 0; i < 20; ++i)
+        x.set(i, ErrorVector<float, 2>(std::array{ErrorValue(1.0f + i, 0.1f), ErrorValue(0.1f*i, 0.02f)}));
+    ErrorVectorArray<float, 2> xy = propagateCovariance(toCartesian, x);
+    ErrorVector<float, 2> e = propagateCovariance(toCartesian, x[19]);
+    ASSERT_NEAR(xy[19].covariance[0][1], e.covariance[0][1], 1e-4);
+    ASSERT_NEAR(xy[19].value[1], e.value[1], 1e-4);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
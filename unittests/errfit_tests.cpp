@@ -0,0 +1,149 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include "errc_fit.h"
+#include "test_data.h"
+
+namespace fit = liberrc::fit;
+using liberrc::ErrorArray;
+using liberrc::simd::Isa;
+
+const double ABSMAX = 0.000001;
+
+void makeLine(std::size_t n, std::vector<double> &x, ErrorArray<double> &y) {
+    x.resize(n);
+    y.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = 0.01*i;
+        double e = 0.1 + 0.05*(i%5);
+        y.set(i, 1.5 - 0.7*x[i] + e*noise(i), e);
+    }
+}
+
+TEST(FitTests, LinearMatchesClosedForm) {
+    std::vector<double> x;
+    ErrorArray<double> y;
+    makeLine(1001, x, y);
+    double s = 0, sx = 0, sxx = 0, sy = 0, sxy = 0;
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        double w = 1/(y.error[i]*y.error[i]);
+        s += w, sx += w*x[i], sxx += w*x[i]*x[i], sy += w*y.value[i], sxy += w*x[i]*y.value[i];
+    }
+    double d = s*sxx - sx*sx;
+
+    fit::Result<double, 1> r = fit::linear(x, y);
+    ASSERT_NEAR(r[0].value, (sxx*sy - sx*sxy)/d, ABSMAX);
+    ASSERT_NEAR(r[1].value, (s*sxy - sx*sy)/d, ABSMAX);
+    ASSERT_NEAR(r[0].error, std::sqrt(sxx/d), ABSMAX);
+    ASSERT_NEAR(r[1].error, std::sqrt(s/d), ABSMAX);
+    ASSERT_NEAR(r.coefficients.covariance[0][1], -sx/d, ABSMAX);
+    ASSERT_EQ(r.degreesOfFreedom, 999);
+    ASSERT_NEAR(r(0).error, r[0].error, ABSMAX);
+}
+
+TEST(FitTests, PolynomialRecoversExactData) {
+    fit::Accumulator<double, 3> acc(5.0);
+    for (std::size_t i = 0; i < 50; ++i) {
+        double u = 0.1*i - 2.5;
+        acc.push(5.0 + u, ErrorValue(2 - u + 0.5*u*u - 0.25*u*u*u, 0.1));
+    }
+    fit::Result<double, 3> r = acc.solve();
+    ASSERT_NEAR(r[0].value, 2, ABSMAX);
+    ASSERT_NEAR(r[1].value, -1, ABSMAX);
+    ASSERT_NEAR(r[2].value, 0.5, ABSMAX);
+    ASSERT_NEAR(r[3].value, -0.25, ABSMAX);
+    ASSERT_NEAR(r.chiSquared, 0, ABSMAX);
+    ASSERT_NEAR(r(6.0).value, 2 - 1 + 0.5 - 0.25, ABSMAX);
+}
+
+TEST(FitTests, WeightedMean) {
+    ErrorArray<double> y = {ErrorValue(1.0, 0.1), ErrorValue(1.2, 0.2), ErrorValue(0.9, 0.05)};
+    fit::Result<double, 0> r = fit::weightedMean(y);
+    ErrorValue<double, double> m = liberrc::weightedMean(y);
+    ASSERT_NEAR(r[0].value, m.value, ABSMAX);
+    ASSERT_NEAR(r[0].error, m.error, ABSMAX);
+    ASSERT_EQ(r.degreesOfFreedom, 2);
+}
+
+TEST(FitTests, KernelsMatchScalar) {
+    std::vector<double> x;
+    ErrorArray<double> y;
+    makeLine(2053, x, y);
+    fit::Accumulator<double, 2> scalar(3.0);
+    for (std::size_t i = 0; i < x.size(); ++i)
+        scalar.push(x[i], y[i]);
+    fit::Result<double, 2> expected = scalar.solve();
+
+    for (Isa isa : {Isa::SCALAR, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+        if (isa > liberrc::simd::detectIsa())
+            continue;
+        fit::Accumulator<double, 2> acc(3.0, fit::kernels<double, 2>(isa));
+        acc.add(x, y);
+        fit::Result<double, 2> r = acc.solve();
+        for (std::size_t i = 0; i < 3; ++i) {
+            ASSERT_NEAR(r[i].value, expected[i].value, ABSMAX);
+            ASSERT_NEAR(r[i].error, expected[i].error, ABSMAX);
+        }
+        ASSERT_NEAR(r.chiSquared, expected.chiSquared, 1e-6);
+    }
+}
+
+TEST(FitTests, MergedPartials) {
+    std::vector<double> x;
+    ErrorArray<double> y;
+    makeLine(300000, x, y);
+    fit::Accumulator<double, 1> a, b;
+    a.add(x.data(), y.value.data(), y.error.data(), 100000);
+    b.add(x.data() + 100000, y.value.data() + 100000, y.error.data() + 100000, 200000);
+    a += b;
+    fit::Result<double, 1> merged = a.solve(), parallel = fit::linear(x, y, 0.0, 4);
+    ASSERT_EQ(a.size(), 300000);
+    ASSERT_NEAR(merged[1].value, parallel[1].value, 1e-9);
+    ASSERT_NEAR(merged[1].error, parallel[1].error, 1e-9);
+    ASSERT_NEAR(merged[1].value, -0.7, 1e-3);
+    ASSERT_THROW((a += fit::Accumulator<double, 1>(1.0)), std::invalid_argument);
+}
+
+TEST(FitTests, Errors) {
+    fit::Accumulator<double, 2> acc;
+    ASSERT_THROW(acc.push(1.0, 2.0, 0.0), std::invalid_argument);
+    acc.push(1.0, 2.0, 0.1);
+    acc.push(1.0, 2.5, 0.1);
+    ASSERT_THROW((void)acc.solve(), std::runtime_error);
+    acc.push(1.0, 2.2, 0.1);
+    ASSERT_THROW((void)acc.solve(), std::runtime_error);
+}
+
+TEST(FitTests, Float) {
+    std::vector<float> x(10000);
+    ErrorArray<float> y(10000);
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        x[i] = 0.001f*i;
+        y.set(i, 2.0f + 3.0f*x[i], 0.5f);
+    }
+    fit::Result<float, 1> r = fit::linear(x, y, 5.0f);
+    ASSERT_NEAR(r[0].value, 17.0, 1e-3);
+    ASSERT_NEAR(r[1].value, 3.0, 1e-3);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
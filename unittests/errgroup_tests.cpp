@@ -0,0 +1,165 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <limits>
+#include <map>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "errc_group.h"
+#include "test_data.h"
+
+using liberrc::ErrorArray;
+using liberrc::GroupedMean;
+
+const double ABSMAX = 0.000001;
+
+struct Sums {
+    double w = 0, wx = 0, chiSquared = 0;
+    std::uint64_t n = 0;
+};
+
+void makeRows(std::size_t n, std::size_t groups, std::vector<std::uint64_t> &keys, ErrorArray<double> &x,
+              std::map<std::uint64_t, Sums> &expected) {
+    keys.resize(n);
+    x.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        // Multiples of 1024 collide in the low bits of an identity hash
+        keys[i] = 1024*((i*7919)%groups);
+        double e = 0.1 + 0.05*(i%7);
+        x.set(i, keys[i]*0.001 + e*noise(i), e);
+        Sums &s = expected[keys[i]];
+        double w = 1/(e*e);
+        s.w += w, s.wx += w*x.value[i], ++s.n;
+    }
+    // Second pass about the mean, free of cancellation
+    for (std::size_t i = 0; i < n; ++i) {
+        Sums &s = expected[keys[i]];
+        double r = (x.value[i] - s.wx/s.w)/x.error[i];
+        s.chiSquared += r*r;
+    }
+}
+
+void checkGroups(const GroupedMean<std::uint64_t> &g, const std::map<std::uint64_t, Sums> &expected) {
+    ASSERT_EQ(g.size(), expected.size());
+    liberrc::Groups<std::uint64_t, double> emitted = g.emit();
+    ASSERT_EQ(emitted.size(), expected.size());
+    for (std::size_t i = 0; i < emitted.size(); ++i) {
+        const Sums &s = expected.at(emitted.keys[i]);
+        ASSERT_NEAR(emitted.means.value[i], s.wx/s.w, ABSMAX);
+        ASSERT_NEAR(emitted.means.error[i], 1/std::sqrt(s.w), ABSMAX);
+        ASSERT_NEAR(emitted.chiSquared[i], s.chiSquared, ABSMAX*s.chiSquared);
+        ASSERT_EQ(emitted.rows[i], s.n);
+        ASSERT_EQ(g.rows(emitted.keys[i]), s.n);
+        ASSERT_NEAR(g.at(emitted.keys[i]).value, s.wx/s.w, ABSMAX);
+    }
+}
+
+TEST(GroupTests, MatchesMapOfVectors) {
+    std::vector<std::uint64_t> keys;
+    ErrorArray<double> x;
+    std::map<std::uint64_t, Sums> expected;
+    makeRows(100000, 3001, keys, x, expected);
+
+    GroupedMean<std::uint64_t> g;
+    g.add(keys, x);
+    checkGroups(g, expected);
+    ASSERT_FALSE(g.contains(1));
+    ASSERT_EQ(g.rows(1), 0u);
+    ASSERT_THROW((void)g.at(1), std::out_of_range);
+}
+
+TEST(GroupTests, SingleRowsAndFirstAppearanceOrder) {
+    GroupedMean<std::string, float> g;
+    g.add("b", ErrorValue<float, float>(2.0f, 1.0f));
+    g.add("a", 1.0f, 0.5f);
+    g.add("b", 4.0f, 1.0f);
+    liberrc::Groups<std::string, float> emitted = g.emit();
+    ASSERT_EQ(emitted.keys, (std::vector<std::string>{"b", "a"}));
+    ASSERT_NEAR(emitted.means.value[0], 3, ABSMAX);
+    ASSERT_NEAR(emitted.means.error[0], std::sqrt(0.5), ABSMAX);
+    ASSERT_NEAR(emitted.chiSquared[0], 2, ABSMAX);
+    ASSERT_NEAR(emitted.means.value[1], 1, ABSMAX);
+    ASSERT_EQ(emitted.rows[1], 1u);
+
+    std::size_t visited = 0;
+    g.forEach([&](const std::string &key, const ErrorValue<float, float> &mean, std::uint64_t rows) {
+        ASSERT_EQ(key, emitted.keys[visited]);
+        ASSERT_EQ(mean.value, emitted.means.value[visited]);
+        ASSERT_EQ(rows, emitted.rows[visited]);
+        ++visited;
+    });
+    ASSERT_EQ(visited, 2u);
+}
+
+TEST(GroupTests, MergePartials) {
+    std::vector<std::uint64_t> keys;
+    ErrorArray<double> x;
+    std::map<std::uint64_t, Sums> expected;
+    makeRows(20000, 500, keys, x, expected);
+
+    GroupedMean<std::uint64_t> a, b(1000);
+    a.add(keys.data(), x.value.data(), x.error.data(), 7000);
+    b.add(keys.data() + 7000, x.value.data() + 7000, x.error.data() + 7000, 13000);
+    a += b;
+    checkGroups(a, expected);
+}
+
+TEST(GroupTests, ParallelMatchesSerial) {
+    std::vector<std::uint64_t> keys;
+    ErrorArray<double> x;
+    std::map<std::uint64_t, Sums> expected;
+    makeRows(1 << 19, 50000, keys, x, expected);
+
+    for (unsigned threads : {1u, 3u, 8u}) {
+        GroupedMean<std::uint64_t> g = liberrc::groupedMean(keys, x, threads);
+        checkGroups(g, expected);
+    }
+}
+
+TEST(GroupTests, InvalidInput) {
+    GroupedMean<int> g;
+    ASSERT_THROW(g.add(1, 1.0, 0.0), std::invalid_argument);
+    ErrorArray<double> x = {ErrorValue(1.0, 0.1), ErrorValue(2.0, -0.1)};
+    ASSERT_THROW(g.add(std::vector<int>{1, 2}, x), std::invalid_argument);
+    ASSERT_THROW(g.add(std::vector<int>{1}, x), std::invalid_argument);
+    // An infinite error would give the group weight 0 and a 0/0 mean, a NaN value would poison the group
+    const double inf = std::numeric_limits<double>::infinity(), nan = std::numeric_limits<double>::quiet_NaN();
+    ASSERT_THROW(g.add(1, 1.0, inf), std::invalid_argument);
+    ASSERT_THROW(g.add(1, nan, 0.1), std::invalid_argument);
+    ASSERT_THROW(g.add(1, inf, 0.1), std::invalid_argument);
+    ASSERT_THROW(g.add(1, 1.0, nan), std::invalid_argument);
+    x = {ErrorValue(1.0, 0.1), ErrorValue(2.0, inf)};
+    ASSERT_THROW(g.add(std::vector<int>{1, 2}, x), std::invalid_argument);
+    x = {ErrorValue(nan, 0.1), ErrorValue(2.0, 0.1)};
+    ASSERT_THROW(g.add(std::vector<int>{1, 2}, x), std::invalid_argument);
+    ASSERT_TRUE(g.empty());
+    // The threaded path checks the rows before splitting them
+    std::vector<int> keys(1 << 18, 1);
+    std::vector<double> values(keys.size(), 1.0), errors(keys.size(), 0.1);
+    values[200000] = nan;
+    ASSERT_THROW(liberrc::groupedMean(keys.data(), values.data(), errors.data(), keys.size(), 4),
+                 std::invalid_argument);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,123 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+#include "errc.h"
+#include "errc_instrument.h"
+#include "errc_propagate.h"
+
+namespace instrument = liberrc::instrument;
+using instrument::Op;
+
+const double ABSMAX = 0.000001;
+
+double totalVariance(const ErrorValue<double, double> &ev) {
+    double total = 0;
+    for (const instrument::Contribution &c : instrument::attribution(ev))
+        total += c.variance;
+    return total;
+}
+
+TEST(InstrumentCountersTests, CountsOperatorsAndErrmath) {
+    static_assert(instrument::enabled(), "Instrumentation tests must be built with LIBERRC_INSTRUMENT");
+    ErrorValue a(2.0, 0.1), b(3.0, 0.2), c(1.0, 0.05);
+    instrument::reset();
+    ErrorValue r = sqrt(a*b + c);
+    instrument::Snapshot s = instrument::snapshot();
+    ASSERT_EQ(s[Op::MUL], 1);
+    ASSERT_EQ(s[Op::ADD], 1);
+    ASSERT_EQ(s[Op::SQRT], 1);
+    ASSERT_EQ(s[Op::SIN], 0);
+
+    r = sin(r);
+    instrument::Snapshot d = instrument::snapshot() - s;
+    ASSERT_EQ(d[Op::SIN], 1);
+    ASSERT_EQ(d[Op::SQRT], 0);
+
+    // Postfix forms go through the prefix ones and count once
+    ErrorValue i(1.0, 0.1);
+    instrument::reset();
+    ++i;
+    i++;
+    --i;
+    ASSERT_EQ(instrument::snapshot()[Op::INC], 2);
+    ASSERT_EQ(instrument::snapshot()[Op::DEC], 1);
+    ASSERT_EQ(i.error, 0.1);
+}
+
+TEST(InstrumentCountersTests, Dump) {
+    instrument::reset();
+    ErrorValue a(2.0, 0.1);
+    a = exp(a);
+    std::ostringstream os;
+    instrument::dump(os);
+    ASSERT_NE(os.str().find("exp 1\n"), std::string::npos);
+    ASSERT_NE(os.str().find("add 0\n"), std::string::npos);
+}
+
+TEST(InstrumentBudgetTests, SumAttribution) {
+    ErrorValue a(2.0, 0.1), b(3.0, 0.2);
+    instrument::name(a, "a");
+    instrument::name(b, "b");
+    ErrorValue r = a + b;
+    std::vector<instrument::Contribution> c = instrument::attribution(r);
+    ASSERT_EQ(c.size(), 2);
+    ASSERT_EQ(c[0].name, "b");
+    ASSERT_NEAR(c[0].variance, 0.04, ABSMAX);
+    ASSERT_NEAR(c[0].fraction, 0.8, ABSMAX);
+    ASSERT_EQ(c[1].name, "a");
+    ASSERT_NEAR(c[1].variance, 0.01, ABSMAX);
+}
+
+TEST(InstrumentBudgetTests, ChainAttributionMatchesError) {
+    ErrorValue a(2.0, 0.1), b(3.0, 0.2), c(0.5, 0.01);
+    instrument::name(a, "a");
+    instrument::name(b, "b");
+    ErrorValue r = log(a*b/c) + pow(a, 2) + ErrorValue(1.0, 0.3);
+    ASSERT_NEAR(totalVariance(r), r.error*r.error, ABSMAX);
+    std::vector<instrument::Contribution> attr = instrument::attribution(r);
+    ASSERT_EQ(attr.size(), 3);
+    ASSERT_EQ(attr[0].name, "a");
+    ASSERT_NE(std::find_if(attr.begin(), attr.end(), [](const instrument::Contribution &x) {
+        return x.name == "<unnamed>";
+    }), attr.end());
+
+    r = 5;
+    ASSERT_TRUE(instrument::attribution(r).empty());
+}
+
+TEST(InstrumentBudgetTests, PropagateAttribution) {
+    instrument::reset();
+    ErrorValue a(2.0, 0.1), b(3.0, 0.2);
+    instrument::name(a, "a");
+    instrument::name(b, "b");
+    ErrorValue<double, double> r = liberrc::propagate([](auto x, auto y) { return x*x*y; }, a, b);
+    ASSERT_EQ(instrument::snapshot()[Op::PROPAGATE], 1);
+    ASSERT_NEAR(totalVariance(r), r.error*r.error, ABSMAX);
+    std::vector<instrument::Contribution> attr = instrument::attribution(r);
+    ASSERT_EQ(attr[0].name, "a");
+    ASSERT_NEAR(attr[0].variance, 12.0*12.0*0.01, ABSMAX);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
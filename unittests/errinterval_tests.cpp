@@ -0,0 +1,153 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "gtest/gtest.h"
+
+#include "errc_interval.h"
+#include "test_data.h"
+
+using liberrc::Band;
+using liberrc::ErrorArray;
+using liberrc::IntervalIndex;
+using liberrc::IntervalMatches;
+
+using Pairs = std::vector<std::pair<std::size_t, std::size_t>>;
+
+// Values in [0, 100), small errors with every 97th element a wide outlier
+ErrorArray<double> makeData(std::size_t n, std::size_t seed = 0) {
+    return generateArray<double>(n, [seed](std::size_t i) {
+        double e = i%97 == 0 ? 20*uniform(3*i + seed + 1) : 0.5*uniform(3*i + seed + 2);
+        return ErrorValue(100*uniform(3*i + seed), i%2 ? e : -e);
+    });
+}
+
+std::vector<std::size_t> bruteForce(const ErrorArray<double> &x, double q, double eq, double k, Band band) {
+    std::vector<std::size_t> res;
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        double e = std::abs(x.error[i]);
+        double r = band == Band::OVERLAP ? k*(e + eq) : k*std::sqrt(e*e + eq*eq);
+        if (std::abs(x.value[i] - q) <= r)
+            res.push_back(i);
+    }
+    return res;
+}
+
+std::vector<std::size_t> sorted(std::vector<std::size_t> v) {
+    std::sort(v.begin(), v.end());
+    return v;
+}
+
+TEST(IntervalIndexTests, SingleQueriesMatchBruteForce) {
+    ErrorArray<double> x = makeData(5000);
+    IntervalIndex<double> index(x);
+    ASSERT_EQ(index.size(), 5000u);
+    for (std::size_t j = 0; j < 200; ++j) {
+        double q = 110*uniform(j + 7) - 5, eq = 0.3*uniform(j + 11);
+        ASSERT_EQ(sorted(index.stab(q)), bruteForce(x, q, 0, 1, Band::OVERLAP));
+        ASSERT_EQ(sorted(index.overlapping(ErrorValue<double, double>(q, eq), 2)),
+                  bruteForce(x, q, eq, 2, Band::OVERLAP));
+        ASSERT_EQ(sorted(index.consistent(ErrorValue<double, double>(q, eq), 2)),
+                  bruteForce(x, q, eq, 2, Band::CONSISTENT));
+    }
+}
+
+TEST(IntervalIndexTests, StabMatchesMinMax) {
+    ErrorArray<double> x = makeData(1000);
+    IntervalIndex<double> index(x);
+    std::vector<std::size_t> found = index.stab(42.0);
+    ASSERT_FALSE(found.empty());
+    for (std::size_t i : found) {
+        ASSERT_LE(std::min(x[i].min(), x[i].max()), 42.0);
+        ASSERT_GE(std::max(x[i].min(), x[i].max()), 42.0);
+    }
+}
+
+TEST(IntervalIndexTests, BatchedQueriesMatchSingle) {
+    ErrorArray<double> x = makeData(5000);
+    ErrorArray<double> q = makeData(3000, 17);
+    IntervalIndex<double> index(x);
+    for (unsigned threads : {1u, 4u}) {
+        IntervalMatches overlap = index.overlapping(q, 1.5, threads);
+        IntervalMatches consistent = index.consistent(q, 1.5, threads);
+        IntervalMatches stab = index.stab(q.value, threads);
+        ASSERT_EQ(overlap.size(), q.size());
+        for (std::size_t j = 0; j < q.size(); ++j) {
+            ASSERT_EQ(overlap[j], index.overlapping(q[j], 1.5));
+            ASSERT_EQ(consistent[j], index.consistent(q[j], 1.5));
+            ASSERT_EQ(stab[j], index.stab(q.value[j]));
+        }
+    }
+}
+
+TEST(IntervalIndexTests, JoinsMatchBruteForce) {
+    ErrorArray<double> a = makeData(800), b = makeData(600, 5);
+    IntervalIndex<double> ia(a), ib(b);
+    Pairs expected, expectedSelf;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        for (std::size_t j = 0; j < b.size(); ++j)
+            if (std::abs(a.value[i] - b.value[j]) <= 2*(std::abs(a.error[i]) + std::abs(b.error[j])))
+                expected.emplace_back(i, j);
+        for (std::size_t j = i + 1; j < a.size(); ++j)
+            if (std::abs(a.value[i] - a.value[j]) <= 2*(std::abs(a.error[i]) + std::abs(a.error[j])))
+                expectedSelf.emplace_back(i, j);
+    }
+
+    for (unsigned threads : {1u, 3u}) {
+        Pairs join = ia.overlapJoin(ib, 2, threads), self = ia.overlapJoin(2, threads);
+        std::sort(join.begin(), join.end());
+        std::sort(self.begin(), self.end());
+        ASSERT_EQ(join, expected);
+        ASSERT_EQ(self, expectedSelf);
+    }
+}
+
+TEST(IntervalIndexTests, ParallelBuild) {
+    ErrorArray<float> x(100000);
+    for (std::size_t i = 0; i < x.size(); ++i)
+        x.set(i, static_cast<float>(1000*uniform(i)), 0.01f);
+    IntervalIndex<float> serial(x, 1), parallel(x, 4);
+    for (float q : {0.5f, 250.0f, 999.0f}) {
+        std::vector<std::size_t> s = serial.stab(q);
+        ASSERT_EQ(s, parallel.stab(q));
+        for (std::size_t i : s)
+            ASSERT_LE(std::abs(x.value[i] - q), 0.01f);
+    }
+
+    std::vector<std::size_t> v(x.size());
+    for (std::size_t i = 0; i < v.size(); ++i)
+        v[i] = (i*7919)%v.size();
+    liberrc::parallel::sort(v, std::less<std::size_t>(), 4);
+    for (std::size_t i = 0; i < v.size(); ++i)
+        ASSERT_EQ(v[i], i);
+}
+
+TEST(IntervalIndexTests, Empty) {
+    IntervalIndex<double> index((ErrorArray<double>()));
+    ASSERT_TRUE(index.empty());
+    ASSERT_TRUE(index.stab(1.0).empty());
+    ASSERT_TRUE(index.overlapJoin().empty());
+    ASSERT_EQ(index.stab(std::vector<double>{1.0, 2.0}).indices.size(), 0u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -18,10 +18,11 @@
  *  see <https://www.gnu.org/licenses/>.
  */
 
-#include "gtest/gtest.h"
-
+// errc.h first, so errmath can not rely on headers that bring the floating-point abs into the global namespace
 #include "errc.h"
 
+#include "gtest/gtest.h"
+
 const double ABSMAX = 0.000001;
 
 TEST(TrigonometricFunctionsTests, Sin) {
@@ -66,6 +67,12 @@ TEST(TrigonometricFunctionsTests, ArcTan2) {
     ASSERT_NEAR(a.error, 0.128'649'457, ABSMAX);
 }
 
+TEST(TrigonometricFunctionsTests, ArcTan2SecondQuadrant) {
+    ErrorValue a = atan2(ErrorValue(0.83, 0.038), ErrorValue(-0.43, 0.134));
+    ASSERT_NEAR(a.value, 2.048'797'017, ABSMAX);
+    ASSERT_NEAR(a.error, 0.128'649'457, ABSMAX);
+}
+
 TEST(HyperbolicTrigonometricFunctionsTests, Sinh) {
     ErrorValue a = sinh(ErrorValue(1.23, 0.038));
     ASSERT_NEAR(a.value, 1.564'468'479, ABSMAX);
@@ -204,6 +211,16 @@ TEST(OtherFunctionsTests, Abs) {
     ASSERT_NEAR(abs(-a).error, 0.12345, ABSMAX);
 }
 
+TEST(OtherFunctionsTests, DerivativeMagnitudeIsNotTruncated) {
+    // C abs(int) would cut |cos(0.5)| = 0.877... and |sinh(0.5)| = 0.521... to 0
+    ErrorValue a = sin(ErrorValue(0.5, 0.3));
+    ASSERT_NEAR(a.error, std::cos(0.5)*0.3, ABSMAX);
+    ASSERT_NE(a.error, std::trunc(a.error));
+    ASSERT_NEAR(cosh(ErrorValue(0.5, 0.3)).error, std::sinh(0.5)*0.3, ABSMAX);
+    ASSERT_NEAR(cos(ErrorValue<float, float>(0.5f, 0.3f)).error, std::sin(0.5f)*0.3f, ABSMAX);
+    ASSERT_NEAR(pow(ErrorValue(0.3, 0.1), 2).error, 2*0.3*0.1, ABSMAX);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,127 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include "errc_ode.h"
+
+namespace ode = liberrc::ode;
+using liberrc::ErrorVector;
+using liberrc::ErrorVectorArray;
+using liberrc::simd::Isa;
+
+const double ABSMAX = 0.000001;
+const std::size_t N = 37;
+
+// y' = -k*y
+auto decay = [](double, const auto &y, const auto &p) {
+    return std::array{-p[0]*y[0]};
+};
+
+// x' = v, v' = -x
+auto oscillator = [](double, const auto &y, const auto &) {
+    return std::array{y[1], -y[0]};
+};
+
+void assertNear(const ErrorVector<double, 2> &a, const ErrorVector<double, 2> &b, double eps) {
+    for (std::size_t i = 0; i < 2; ++i) {
+        ASSERT_NEAR(a.value[i], b.value[i], eps);
+        for (std::size_t j = 0; j < 2; ++j)
+            ASSERT_NEAR(a.covariance[i][j], b.covariance[i][j], eps);
+    }
+}
+
+TEST(OdeTests, DecaySensitivities) {
+    ErrorVector<double, 1> y0(std::array{ErrorValue(2.0, 0.1)});
+    ErrorVector<double, 1> k(std::array{ErrorValue(0.5, 0.02)});
+    double t = 3, e = std::exp(-0.5*t);
+    // y = y0*exp(-k*t): dy/dy0 = exp(-k*t), dy/dk = -t*y0*exp(-k*t)
+    double error = std::hypot(e*0.1, t*2*e*0.02);
+
+    ErrorVector<double, 1> a = ode::rk4(decay, 0.0, t, 200, y0, k);
+    ASSERT_NEAR(a.value[0], 2*e, ABSMAX);
+    ASSERT_NEAR(a[0].error, error, ABSMAX);
+
+    ErrorVector<double, 1> b = ode::rk45(decay, 0.0, t, y0, k, ode::Options<double>{1e-10, 1e-12});
+    ASSERT_NEAR(b.value[0], 2*e, ABSMAX);
+    ASSERT_NEAR(b[0].error, error, ABSMAX);
+}
+
+TEST(OdeTests, OscillatorCorrelations) {
+    // x = x0*cos(t) + v0*sin(t), v = -x0*sin(t) + v0*cos(t)
+    double t = 2, c = std::cos(t), s = std::sin(t), sx = 0.1, sv = 0.2;
+    ErrorVector<double, 2> y0(std::array{ErrorValue(1.0, sx), ErrorValue(0.0, sv)});
+    ErrorVector<double, 2> expected({c, -s}, {{{c*c*sx*sx + s*s*sv*sv, -c*s*sx*sx + s*c*sv*sv},
+                                               {-c*s*sx*sx + s*c*sv*sv, s*s*sx*sx + c*c*sv*sv}}});
+    assertNear(ode::rk4(oscillator, 0.0, t, 400, y0), expected, ABSMAX);
+    assertNear(ode::rk45(oscillator, 0.0, t, y0, ode::Options<double>{1e-10, 1e-12}), expected, ABSMAX);
+}
+
+TEST(OdeTests, Errors) {
+    ErrorVector<double, 2> y0(std::array{ErrorValue(1.0, 0.1), ErrorValue(0.0, 0.1)});
+    ode::Options<double> options;
+    options.maxSteps = 3;
+    ASSERT_THROW(ode::rk45(oscillator, 0.0, 100.0, y0, options), std::runtime_error);
+    ASSERT_THROW(ode::rk4(oscillator, 1.0, 0.0, 10, y0), std::invalid_argument);
+    ASSERT_THROW(ode::rk4(decay, 0.0, 1.0, 10, ErrorVectorArray<double, 1>(3), ErrorVectorArray<double, 1>(2)),
+                 std::invalid_argument);
+}
+
+TEST(OdeBatchTests, KernelsMatchScalar) {
+    ErrorVectorArray<double, 2> y0(N);
+    ErrorVectorArray<double, 1> k(N);
+    auto damped = [](double, const auto &y, const auto &p) {
+        return std::array{y[1], -y[0] - p[0]*y[1]};
+    };
+    for (std::size_t i = 0; i < N; ++i) {
+        y0.set(i, ErrorVector<double, 2>({1.0 + 0.1*i, -0.5}, {{{0.01, 0.002}, {0.002, 0.04}}}));
+        k.set(i, ErrorVector<double, 1>(std::array{ErrorValue(0.05*i, 0.01)}));
+    }
+    ode::Options<double> options;
+    options.threads = 3;
+
+    for (Isa isa : {Isa::SCALAR, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+        if (isa > liberrc::simd::detectIsa())
+            continue;
+        const ode::Kernels<double> &kernels = ode::kernels<double>(isa);
+        ErrorVectorArray<double, 2> a = ode::rk4(damped, 0.0, 1.5, 50, y0, k, 3, kernels);
+        ErrorVectorArray<double, 2> b = ode::rk45(damped, 0.0, 1.5, y0, k, options, kernels);
+        ASSERT_EQ(a.size(), N);
+        for (std::size_t i = 0; i < N; ++i) {
+            assertNear(a[i], ode::rk4(damped, 0.0, 1.5, 50, y0[i], k[i]), ABSMAX);
+            // Blocks share their step size, so the adaptive results agree to the tolerance only
+            assertNear(b[i], ode::rk45(damped, 0.0, 1.5, y0[i], k[i]), 1e-5);
+        }
+    }
+}
+
+TEST(OdeBatchTests, Float) {
+    ErrorVectorArray<float, 2> y0(20);
+    for (std::size_t i = 0; i < 20; ++i)
+        y0.set(i, ErrorVector<float, 2>(std::array{ErrorValue(1.0f*i, 0.1f), ErrorValue(1.0f, 0.2f)}));
+    auto f = [](float, const auto &y, const auto &) { return std::array{y[1], -y[0]}; };
+    ErrorVectorArray<float, 2> y = ode::rk4(f, 0.0f, 1.0f, 100, y0);
+    ErrorVector<float, 2> e = ode::rk4(f, 0.0f, 1.0f, 100, y0[19]);
+    ASSERT_NEAR(y[19].value[0], e.value[0], 1e-4);
+    ASSERT_NEAR(y[19].covariance[0][1], e.covariance[0][1], 1e-4);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,162 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "errc_poly.h"
+#include "test_data.h"
+
+using liberrc::ErrorArray;
+using liberrc::simd::Isa;
+namespace poly = liberrc::poly;
+
+const double ABSMAX = 0.000001;
+
+using EV = ErrorValue<double, double>;
+
+// Direct sums of the powers, the reference for Horner's scheme
+EV reference(const std::vector<EV> &c, const EV &x) {
+    double value = 0, derivative = 0, variance = 0;
+    for (std::size_t k = 0; k < c.size(); ++k) {
+        value += c[k].value*std::pow(x.value, k);
+        if (k > 0)
+            derivative += k*c[k].value*std::pow(x.value, k - 1);
+        variance += std::pow(c[k].error*std::pow(x.value, k), 2);
+    }
+    return EV(value, std::sqrt(derivative*derivative*x.error*x.error + variance));
+}
+
+std::vector<EV> coefficients(std::size_t terms, std::size_t seed) {
+    std::vector<EV> c;
+    for (std::size_t k = 0; k < terms; ++k)
+        c.emplace_back(noise(seed + k), 0.01*(1 + std::abs(noise(seed + 100 + k))));
+    return c;
+}
+
+// The same coefficients for the ErrorArray overloads and the kernels
+template <typename T>
+ErrorArray<T> toArray(const std::vector<EV> &c) {
+    return generateArray<T>(c.size(), [&c](std::size_t k) { return c[k]; });
+}
+
+TEST(PolyTests, PolyvalMatchesDirectSum) {
+    for (std::size_t terms : {1u, 2u, 6u, 10u}) {
+        std::vector<EV> c = coefficients(terms, terms);
+        for (std::size_t i = 0; i < 50; ++i) {
+            EV x(1.5*noise(i), 0.02);
+            EV expected = reference(c, x);
+            EV got = liberrc::polyval(c, x);
+            ASSERT_NEAR(got.value, expected.value, ABSMAX);
+            ASSERT_NEAR(got.error, expected.error, ABSMAX);
+            got = liberrc::polyval(toArray<double>(c), x);
+            ASSERT_NEAR(got.value, expected.value, ABSMAX);
+            ASSERT_NEAR(got.error, expected.error, ABSMAX);
+        }
+    }
+    ASSERT_EQ(liberrc::polyval(std::vector<EV>{}, EV(2.0, 0.1)).value, 0);
+}
+
+TEST(PolyTests, RepeatedXIsCorrelated) {
+    // x^2 through chained multiplication treats both factors as independent and gives sqrt(2)*x*ex
+    EV x(3.0, 0.1);
+    std::vector<EV> square = {EV(0.0, 0.0), EV(0.0, 0.0), EV(1.0, 0.0)};
+    EV got = liberrc::polyval(square, x);
+    ASSERT_NEAR(got.value, 9, ABSMAX);
+    ASSERT_NEAR(got.error, 2*3*0.1, ABSMAX);
+    ASSERT_NEAR((x*x).error, std::sqrt(2.0)*3*0.1, ABSMAX);
+
+    // (x - 1)/(x - 1) is 1 without error
+    EV one = liberrc::ratval(std::vector<EV>{EV(-1.0, 0.0), EV(1.0, 0.0)},
+                             std::vector<EV>{EV(-1.0, 0.0), EV(1.0, 0.0)}, x);
+    ASSERT_NEAR(one.value, 1, ABSMAX);
+    ASSERT_NEAR(one.error, 0, ABSMAX);
+}
+
+TEST(PolyTests, RatvalMatchesQuotient) {
+    std::vector<EV> p = coefficients(6, 1), q = coefficients(4, 2);
+    q[0] = EV(3.0, 0.05);
+    for (std::size_t i = 0; i < 50; ++i) {
+        EV x(noise(i), 0.01);
+        EV a = reference(p, EV(x.value, 0.0)), b = reference(q, EV(x.value, 0.0));
+        double r = a.value/b.value;
+        // Central difference for the slope, coefficient variances of p and q scaled by the quotient rule
+        double h = 1e-6;
+        double slope = (reference(p, EV(x.value + h, 0.0)).value/reference(q, EV(x.value + h, 0.0)).value -
+                        reference(p, EV(x.value - h, 0.0)).value/reference(q, EV(x.value - h, 0.0)).value)/(2*h);
+        double variance = slope*slope*x.error*x.error + (a.error*a.error + r*r*b.error*b.error)/(b.value*b.value);
+
+        EV got = liberrc::ratval(p, q, x);
+        ASSERT_NEAR(got.value, r, ABSMAX);
+        ASSERT_NEAR(got.error, std::sqrt(variance), ABSMAX);
+        got = liberrc::ratval(toArray<double>(p), toArray<double>(q), x);
+        ASSERT_NEAR(got.value, r, ABSMAX);
+        ASSERT_NEAR(got.error, std::sqrt(variance), ABSMAX);
+    }
+    ASSERT_THROW((void)liberrc::ratval(p, std::vector<EV>{}, EV(1.0, 0.1)), std::invalid_argument);
+}
+
+template <typename T>
+void checkBatch(double tolerance) {
+    std::vector<EV> p = coefficients(9, 3), q = coefficients(5, 4);
+    q[0] = EV(4.0, 0.02);
+    ErrorArray<T> pa = toArray<T>(p), qa = toArray<T>(q);
+    // 37 elements leave a tail after the unrolled and single packs of every ISA
+    ErrorArray<T> x = generateArray<T>(37, [](std::size_t i) { return EV(noise(i), 0.01 + 0.001*i); });
+
+    for (Isa isa : {Isa::SCALAR, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+        if (isa > liberrc::simd::detectIsa())
+            continue;
+        const poly::Kernels<T> &kernels = poly::kernels<T>(isa);
+        ErrorArray<T> rp(x.size()), rq(x.size());
+        kernels.polyval(pa.value.data(), pa.error.data(), pa.size(), x.value.data(), x.error.data(),
+                        rp.value.data(), rp.error.data(), x.size());
+        kernels.ratval(pa.value.data(), pa.error.data(), pa.size(), qa.value.data(), qa.error.data(), qa.size(),
+                       x.value.data(), x.error.data(), rq.value.data(), rq.error.data(), x.size());
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            ErrorValue<T, T> ep = liberrc::polyval(pa, x[i]), eq = liberrc::ratval(pa, qa, x[i]);
+            ASSERT_NEAR(rp.value[i], ep.value, tolerance);
+            ASSERT_NEAR(rp.error[i], ep.error, tolerance);
+            ASSERT_NEAR(rq.value[i], eq.value, tolerance);
+            ASSERT_NEAR(rq.error[i], eq.error, tolerance);
+        }
+    }
+
+    ErrorArray<T> rp = liberrc::polyval(pa, x), rq = liberrc::ratval(pa, qa, x);
+    ASSERT_EQ(rp.size(), x.size());
+    ASSERT_NEAR(rq.value[5], liberrc::ratval(pa, qa, x[5]).value, tolerance);
+    // Results may overwrite x
+    poly::polyval(pa.value.data(), pa.error.data(), pa.size(), x.value.data(), x.error.data(),
+                  x.value.data(), x.error.data(), x.size());
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        ASSERT_NEAR(x.value[i], rp.value[i], tolerance);
+        ASSERT_NEAR(x.error[i], rp.error[i], tolerance);
+    }
+}
+
+TEST(PolyTests, BatchMatchesScalar) {
+    checkBatch<double>(ABSMAX);
+    checkBatch<float>(0.0001);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,76 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include "errc_propagate.h"
+
+using liberrc::propagate;
+
+const double ABSMAX = 0.000001;
+
+void assertNear(const ErrorValue<double, double> &a, const ErrorValue<double, double> &b) {
+    ASSERT_NEAR(a.value, b.value, ABSMAX);
+    ASSERT_NEAR(a.error, b.error, ABSMAX);
+}
+
+TEST(PropagateTests, MatchesErrmath) {
+    ErrorValue x(0.83, 0.038), y(0.43, 0.134);
+    assertNear(propagate([](auto v) { using std::sin; return sin(v); }, x), sin(x));
+    assertNear(propagate([](auto v) { using std::acos; return acos(v); }, x), acos(x));
+    assertNear(propagate([](auto v) { using std::erfc; return erfc(v); }, x), erfc(x));
+    assertNear(propagate([](auto a, auto b) { using std::pow; return pow(a, b); }, x, y), pow(x, y));
+    assertNear(propagate([](auto a, auto b) { using std::hypot; return hypot(a, b); }, x, y), hypot(x, y));
+    assertNear(propagate([](auto a, auto b) { using std::atan2; return atan2(a, b); }, x, y), atan2(x, y));
+    assertNear(propagate([](auto a, auto b) { return a*b; }, x, y), x*y);
+}
+
+TEST(PropagateTests, UserFunction) {
+    // Gaussian g(x; mu, s) = exp(-(x - mu)^2/(2 s^2)), not in errmath
+    auto gauss = [](auto x, auto mu, auto s) {
+        using std::exp;
+        auto z = (x - mu)/s;
+        return exp(-z*z/2);
+    };
+    ErrorValue x(1.2, 0.05), mu(1.0, 0.02), s(0.5, 0.01);
+    ErrorValue<double, double> g = propagate(gauss, x, mu, s);
+
+    double z = 0.4, e = std::exp(-z*z/2);
+    double dx = -e*z/0.5, dmu = e*z/0.5, ds = e*z*z/0.5;
+    ASSERT_NEAR(g.value, e, ABSMAX);
+    ASSERT_NEAR(g.error, std::sqrt(std::pow(dx*0.05, 2) + std::pow(dmu*0.02, 2) + std::pow(ds*0.01, 2)), ABSMAX);
+}
+
+TEST(PropagateTests, MixedTypes) {
+    ErrorValue<int, double> n(3, 0.5);
+    ErrorValue<float, float> f(2.0f, 0.1f);
+    ErrorValue<double, double> r = propagate([](auto a, auto b) { return a*b + 1; }, n, f);
+    ASSERT_NEAR(r.value, 7, ABSMAX);
+    ASSERT_NEAR(r.error, std::hypot(2.0*0.5, 3.0*0.1), 1e-6);
+}
+
+TEST(PropagateTests, CancellationOfRepeatedInput) {
+    // x - x has no error, unlike ErrorValue arithmetic which treats both operands as independent
+    ErrorValue x(2.0, 0.1);
+    ASSERT_NEAR(propagate([](auto v) { return v*v - v*v + v; }, x).error, 0.1, ABSMAX);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,106 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include "errc_solve.h"
+
+namespace solve = liberrc::solve;
+using liberrc::ErrorArray;
+
+const double ABSMAX = 0.000001;
+
+// Kepler's equation E - e*sin(E) = M for the eccentric anomaly E
+auto kepler = [](auto E, auto e) {
+    using std::sin;
+    return E - e*sin(E);
+};
+
+// Error of E from dE/dM = 1/(1 - e*cos(E)) and dE/de = sin(E)/(1 - e*cos(E))
+double keplerError(double E, double e, double errorM, double errorE) {
+    double d = 1 - e*std::cos(E);
+    return std::hypot(errorM/d, std::sin(E)/d*errorE);
+}
+
+TEST(SolveTests, NewtonInverse) {
+    ErrorValue target(2.0, 0.01);
+    ErrorValue<double, double> x = solve::newton([](auto v) { return v*v; }, target, 1.0);
+    ASSERT_NEAR(x.value, std::sqrt(2.0), ABSMAX);
+    ASSERT_NEAR(x.error, sqrt(target).error, ABSMAX);
+}
+
+TEST(SolveTests, NewtonWithParameters) {
+    ErrorValue M(1.2, 0.01), e(0.3, 0.02);
+    ErrorValue<double, double> E = solve::newton(kepler, M, 1.0, e);
+    ASSERT_NEAR(E.value - 0.3*std::sin(E.value), 1.2, 1e-12);
+    ASSERT_NEAR(E.error, keplerError(E.value, 0.3, 0.01, 0.02), ABSMAX);
+}
+
+TEST(SolveTests, Brent) {
+    ErrorValue M(1.2, 0.01), e(0.3, 0.02);
+    ErrorValue<double, double> E = solve::brent(kepler, M, 0.0, M_PI, e);
+    ErrorValue<double, double> N = solve::newton(kepler, M, 1.0, e);
+    ASSERT_NEAR(E.value, N.value, 1e-12);
+    ASSERT_NEAR(E.error, N.error, ABSMAX);
+
+    ErrorValue<double, double> c = solve::brent([](auto x) { return x*x*x; }, ErrorValue(-8.0, 0.3), -10, 10);
+    ASSERT_NEAR(c.value, -2, 1e-12);
+    ASSERT_NEAR(c.error, 0.3/12, ABSMAX);
+}
+
+TEST(SolveTests, Errors) {
+    auto square = [](auto x) { return x*x; };
+    ASSERT_THROW(solve::brent(square, ErrorValue(2.0, 0.1), 2.0, 3.0), std::invalid_argument);
+    ASSERT_THROW(solve::newton(square, ErrorValue(2.0, 0.1), 0.0), std::runtime_error);
+    solve::Options<double> options;
+    options.maxIterations = 2;
+    ASSERT_THROW(solve::newton(square, ErrorValue(2.0, 0.1), 100.0, options), std::runtime_error);
+}
+
+TEST(SolveBatchTests, MatchesScalar) {
+    const std::size_t n = 1000;
+    ErrorArray<double> M(n), e(n);
+    std::vector<double> x0(n), lo(n, 0), hi(n, M_PI);
+    for (std::size_t i = 0; i < n; ++i) {
+        M.set(i, 0.1 + 3.0*i/n, 0.001*(i % 7));
+        e.set(i, 0.9*i/n, 0.01);
+        x0[i] = M.value[i];
+    }
+    // No root in [0, pi] for the last instance
+    M.set(n - 1, 4.0, 0.1);
+
+    solve::Options<double> options;
+    options.threads = 4;
+    ErrorArray<double> a = solve::newton(kepler, M, x0, options, e);
+    ErrorArray<double> b = solve::brent(kepler, M, lo, hi, options, e);
+    ASSERT_EQ(a.size(), n);
+    for (std::size_t i = 0; i + 1 < n; ++i) {
+        ErrorValue<double, double> s = solve::newton(kepler, M[i], x0[i], e[i]);
+        ASSERT_NEAR(a.value[i], s.value, 1e-12);
+        ASSERT_NEAR(a.error[i], s.error, 1e-12);
+        ASSERT_NEAR(b.value[i], s.value, 1e-9);
+        ASSERT_NEAR(b.error[i], s.error, 1e-9);
+    }
+    ASSERT_TRUE(std::isnan(b.value[n - 1]));
+    ASSERT_THROW(solve::newton(kepler, M, std::vector<double>(3), e), std::invalid_argument);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,269 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "errc_stream.h"
+
+namespace stream = liberrc::stream;
+
+const double ABSMAX = 0.000001;
+
+TEST(StreamTests, SpscRingKeepsOrder) {
+    stream::SpscRing<std::size_t> ring(5);
+    ASSERT_EQ(ring.capacity(), 8u);
+    for (std::size_t i = 0; i < 8; ++i)
+        ASSERT_TRUE(ring.tryPush(i));
+    ASSERT_FALSE(ring.tryPush(8));
+
+    const std::size_t n = 1000000;
+    std::size_t v = 0;
+    for (std::size_t i = 0; i < 8; ++i) {
+        ASSERT_TRUE(ring.tryPop(v));
+        ASSERT_EQ(v, i);
+    }
+    ASSERT_FALSE(ring.tryPop(v));
+    std::thread producer([&ring]() {
+        for (std::size_t i = 0; i < n; ++i)
+            while (!ring.tryPush(i))
+                std::this_thread::yield();
+    });
+    for (std::size_t i = 0; i < n; ++i) {
+        while (!ring.tryPop(v))
+            std::this_thread::yield();
+        ASSERT_EQ(v, i);
+    }
+    producer.join();
+}
+
+TEST(StreamTests, MpscRingKeepsOrderPerProducer) {
+    stream::MpscRing<std::size_t> ring(64);
+    const std::size_t producers = 4, n = 200000;
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < producers; ++p)
+        threads.emplace_back([&ring, p]() {
+            for (std::size_t i = 0; i < n; ++i)
+                while (!ring.tryPush(p*n + i))
+                    std::this_thread::yield();
+        });
+    std::vector<std::size_t> next(producers, 0);
+    std::size_t v = 0;
+    for (std::size_t i = 0; i < producers*n; ++i) {
+        while (!ring.tryPop(v))
+            std::this_thread::yield();
+        ASSERT_EQ(v%n, next[v/n]++);
+    }
+    for (std::thread &t : threads)
+        t.join();
+    ASSERT_FALSE(ring.tryPop(v));
+}
+
+TEST(StreamTests, PipelineAppliesStagesToEveryReading) {
+    using EV = ErrorValue<double, double>;
+    const std::size_t producers = 3, n = 100000;
+    std::vector<double> values, errors;
+    stream::Options options;
+    options.chunkSize = 1000;
+    options.chunksPerProducer = 4;
+    {
+        stream::Pipeline<double> pipeline({
+                stream::defaultError<double>(EV::DEF_ERROR_HALF),
+                stream::formula<double>([](const EV &x) { return x*2.0 + 1.0; }),
+                [&](stream::Batch<double> &b) {
+                    values.insert(values.end(), b.value, b.value + b.size);
+                    errors.insert(errors.end(), b.error, b.error + b.size);
+                }}, options);
+        std::vector<std::thread> threads;
+        for (std::size_t p = 0; p < producers; ++p)
+            threads.emplace_back([&pipeline, p]() {
+                auto producer = pipeline.producer();
+                for (std::size_t i = 0; i < n; ++i)
+                    producer.push(static_cast<double>(i%1000 + 1) + 0.25*p);
+            });
+        for (std::thread &t : threads)
+            t.join();
+        pipeline.close();
+
+        for (const stream::StageStats &s : pipeline.stats()) {
+            ASSERT_EQ(s.items, producers*n);
+            ASSERT_EQ(s.chunks, producers*n/options.chunkSize);
+            ASSERT_GT(s.throughput(), 0);
+            ASSERT_LE(s.latencyPercentile(0.5), s.latencyPercentile(0.99));
+        }
+    }
+
+    ASSERT_EQ(values.size(), producers*n);
+    std::vector<std::pair<double, double>> got, expected;
+    for (std::size_t i = 0; i < values.size(); ++i)
+        got.emplace_back(values[i], errors[i]);
+    for (std::size_t p = 0; p < producers; ++p)
+        for (std::size_t i = 0; i < n; ++i) {
+            EV x;
+            x.setDefaultErrorCalculationMethod(EV::DEF_ERROR_HALF);
+            x = static_cast<double>(i%1000 + 1) + 0.25*p;
+            EV r = EV(x.value, x.error)*2.0 + 1.0;
+            expected.emplace_back(r.value, r.error);
+        }
+    std::sort(got.begin(), got.end());
+    std::sort(expected.begin(), expected.end());
+    for (std::size_t i = 0; i < got.size(); ++i) {
+        ASSERT_NEAR(got[i].first, expected[i].first, ABSMAX);
+        ASSERT_NEAR(got[i].second, expected[i].second, ABSMAX);
+    }
+}
+
+TEST(StreamTests, CustomErrorAndFlush) {
+    std::vector<ErrorValue<float, float>> results;
+    stream::Pipeline<float> pipeline({
+            stream::defaultError<float>(ErrorValue<float, float>::DEF_ERROR_FUNC, [](float x) { return 0.1f*x; }),
+            stream::formula<float>([](const ErrorValue<float, float> &x) { return sqrt(x); }),
+            [&](stream::Batch<float> &b) {
+                for (std::size_t i = 0; i < b.size; ++i)
+                    results.emplace_back(b.value[i], b.error[i]);
+            }});
+    {
+        auto producer = pipeline.producer();
+        const float readings[] = {4.0f, 9.0f, 16.0f};
+        producer.push(readings, 3);
+        producer.flush();
+    }
+    pipeline.close();
+    ASSERT_EQ(results.size(), 3u);
+    for (std::size_t i = 0; i < 3; ++i) {
+        float x = static_cast<float>((i + 2)*(i + 2));
+        ASSERT_NEAR(results[i].value, std::sqrt(x), ABSMAX);
+        ASSERT_NEAR(results[i].error, 0.1f*x/(2*std::sqrt(x)), ABSMAX);
+    }
+    ASSERT_THROW(stream::defaultError<float>(ErrorValue<float, float>::DEF_ERROR_FUNC), std::bad_function_call);
+}
+
+TEST(StreamTests, RecycledChunksStartWithExactReadings) {
+    using EV = ErrorValue<double, double>;
+    stream::Options options;
+    options.chunkSize = 4;
+    options.chunksPerProducer = 2;
+    std::vector<double> errors;
+    // No defaultError stage, so the first stage sees whatever error the chunk holds
+    stream::Pipeline<double> pipeline({
+            stream::formula<double>([](const EV &x) { return EV(2*x.value, x.error + 0.5); }),
+            [&](stream::Batch<double> &b) { errors.insert(errors.end(), b.error, b.error + b.size); }},
+            options);
+    {
+        auto producer = pipeline.producer();
+        for (std::size_t i = 0; i < 40; ++i)
+            producer.push(static_cast<double>(i));
+        const double readings[] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0};
+        for (std::size_t i = 0; i < 4; ++i)
+            producer.push(readings, 10);
+        producer.flush();
+    }
+    pipeline.close();
+    ASSERT_EQ(errors.size(), 80u);
+    for (double e : errors)
+        ASSERT_NEAR(e, 0.5, ABSMAX);
+}
+
+TEST(StreamTests, BackpressureBoundsReadingsInFlight) {
+    stream::Options options;
+    options.chunkSize = 16;
+    options.chunksPerProducer = 2;
+    std::atomic<bool> release{false};
+    std::atomic<std::size_t> stored{0};
+    stream::Pipeline<double> pipeline({[&](stream::Batch<double> &b) {
+        while (!release.load())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        stored += b.size;
+    }}, options);
+    std::size_t accepted = 0;
+    {
+        auto producer = pipeline.producer();
+        while (producer.tryPush(1.0))
+            ++accepted;
+        // Both chunks are in flight, the stalled stage holds one and the ring the other
+        ASSERT_EQ(accepted, 2*options.chunkSize);
+        release.store(true);
+        for (std::size_t i = 0; i < 1000; ++i)
+            producer.push(2.0);
+    }
+    pipeline.close();
+    ASSERT_EQ(stored.load(), accepted + 1000);
+}
+
+TEST(StreamTests, CloseWhileProducerPushes) {
+    stream::Options options;
+    options.chunkSize = 16;
+    options.chunksPerProducer = 2;
+    std::atomic<std::size_t> pushed{0}, sunk{0};
+    bool refused = false;
+    stream::Pipeline<double> pipeline({[&](stream::Batch<double> &b) { sunk += b.size; }}, options);
+    // The producer handle is destroyed in the thread, its destructor must not wait for a chunk stage 0 never saw
+    std::thread thread([&]() {
+        auto producer = pipeline.producer();
+        try {
+            for (;;) {
+                ++pushed;
+                producer.push(1.0);
+            }
+        } catch (const std::logic_error&) {
+            refused = true;
+            // The chunk the close refused stays full, pushing again refuses again
+            ASSERT_THROW(producer.push(1.0), std::logic_error);
+        }
+    });
+    while (pushed.load() < 1000)
+        std::this_thread::yield();
+    pipeline.close();
+    thread.join();
+    ASSERT_TRUE(refused);
+    // Every chunk submitted before the close was processed, only the refused one is lost
+    ASSERT_EQ(sunk.load(), pushed.load() - options.chunkSize);
+}
+
+TEST(StreamTests, StageExceptionIsRethrownByClose) {
+    std::size_t sunk = 0;
+    stream::Pipeline<double> pipeline({
+            [](stream::Batch<double> &b) {
+                if (b.value[0] < 0)
+                    throw std::domain_error("negative reading");
+            },
+            [&](stream::Batch<double> &b) { sunk += b.size; }});
+    {
+        auto producer = pipeline.producer();
+        producer.push(1.0);
+        producer.flush();
+        producer.push(-1.0);
+        producer.flush();
+        producer.push(2.0);
+        producer.flush();
+    }
+    ASSERT_THROW(pipeline.close(), std::domain_error);
+    ASSERT_EQ(sunk, 2u);
+    auto late = pipeline.producer();
+    late.push(1.0);
+    ASSERT_THROW(late.flush(), std::logic_error);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
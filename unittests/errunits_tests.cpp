@@ -0,0 +1,156 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+#include "errc_units.h"
+
+using namespace liberrc::units;
+
+const double ABSMAX = 0.000001;
+
+using EV = ErrorValue<double, double>;
+
+static_assert(sizeof(Quantity<Joule>) == sizeof(EV), "Quantity must have the size of ErrorValue");
+static_assert(std::is_same<decltype(Quantity<Metre>(1, 0)*Quantity<Metre>(1, 0))::dimension, Area>::value,
+              "Product of lengths must be an area");
+static_assert(std::is_same<CommonUnit<Kilometre, Millimetre>, Millimetre>::value,
+              "Common unit must be the finer one");
+static_assert(std::is_same<CommonUnit<Minute, Hour>, Minute>::value, "Common unit must be the finer one");
+static_assert(std::is_same<decltype(Quantity<Newton>(1, 0)*Quantity<Metre>(1, 0))::dimension, Energy>::value,
+              "Force times length must be an energy");
+
+TEST(UnitsTests, SameUnitArithmeticMatchesErrorValue) {
+    Quantity<Metre> a(3.0, 0.1), b(4.0, 0.2);
+    EV x(3.0, 0.1), y(4.0, 0.2);
+
+    Quantity<Metre> sum = a + b;
+    EV expected = x + y;
+    ASSERT_EQ(sum.value(), expected.value);
+    ASSERT_EQ(sum.error(), expected.error);
+
+    Quantity<SquareMetre> area = a*b;
+    expected = x*y;
+    ASSERT_EQ(area.value(), expected.value);
+    ASSERT_EQ(area.error(), expected.error);
+
+    Quantity<One> ratio = a/b;
+    expected = x/y;
+    ASSERT_EQ(ratio.value(), expected.value);
+    ASSERT_EQ(ratio.error(), expected.error);
+
+    Quantity<Metre> c = a;
+    c += b;
+    c -= a;
+    c *= 2.0;
+    expected = (x + y - x)*2.0;
+    ASSERT_EQ(c.value(), expected.value);
+    ASSERT_EQ(c.error(), expected.error);
+}
+
+TEST(UnitsTests, ScalesConvertExactly) {
+    Quantity<Kilometre> km(1.5, 0.01);
+    Quantity<Metre> m(250.0, 2.0);
+
+    auto sum = km + m;
+    static_assert(std::is_same<decltype(sum), Quantity<Metre>>::value, "km + m must be in metres");
+    ASSERT_NEAR(sum.value(), 1750, ABSMAX);
+    ASSERT_NEAR(sum.error(), std::sqrt(10.0*10.0 + 2.0*2.0), ABSMAX);
+
+    Quantity<Millimetre> mm = km;
+    ASSERT_NEAR(mm.value(), 1500000, ABSMAX);
+    ASSERT_NEAR(mm.error(), 10000, ABSMAX);
+    ASSERT_NEAR(mm.in<Kilometre>().value(), 1.5, ABSMAX);
+
+    Quantity<KilometrePerHour> v(36.0, 0.36);
+    Quantity<MetrePerSecond> si = v;
+    ASSERT_NEAR(si.value(), 10, ABSMAX);
+    ASSERT_NEAR(si.error(), 0.1, ABSMAX);
+
+    Quantity<Metre> d = v*Quantity<Minute>(2.0, 0.0);
+    ASSERT_NEAR(d.value(), 1200, ABSMAX);
+    ASSERT_NEAR(d.error(), 12, ABSMAX);
+
+    ASSERT_TRUE(Quantity<Kilometre>(1.0, 0.0) == Quantity<Metre>(1000.0, 0.0));
+    ASSERT_TRUE(Quantity<Gram>(999.0, 0.0) < Quantity<Kilogram>(1.0, 0.0));
+}
+
+TEST(UnitsTests, Errmath) {
+    Quantity<SquareMetre> area(16.0, 0.8);
+    Quantity<Metre> side = sqrt(area);
+    ASSERT_NEAR(side.value(), 4, ABSMAX);
+    ASSERT_NEAR(side.error(), 0.1, ABSMAX);
+
+    // Square kilometres have an exact root, kilometres
+    Quantity<Kilometre> km = sqrt(Quantity<UnitProduct<Kilometre, Kilometre>>(4.0, 0.4));
+    ASSERT_NEAR(km.value(), 2, ABSMAX);
+    ASSERT_NEAR(km.error(), 0.1, ABSMAX);
+    // Litres are not a cube, the root is taken in cubic metres
+    Quantity<Metre> edge = cbrt(Quantity<Litre>(8000.0, 0.0));
+    ASSERT_NEAR(edge.value(), 2, ABSMAX);
+
+    Quantity<CubicMetre> volume = pow<3>(side);
+    ASSERT_NEAR(volume.value(), 64, ABSMAX);
+    ASSERT_NEAR(volume.error(), 3*16*0.1, ABSMAX);
+    Quantity<Hertz> f = pow<-1>(Quantity<Second>(0.5, 0.0));
+    ASSERT_NEAR(f.value(), 2, ABSMAX);
+
+    Quantity<Metre> h = hypot(Quantity<Metre>(3.0, 0.3), Quantity<Centimetre>(400.0, 40.0));
+    ASSERT_NEAR(h.value(), 5, ABSMAX);
+    ASSERT_NEAR(h.error(), hypot(EV(3.0, 0.3), EV(4.0, 0.4)).error, ABSMAX);
+
+    Quantity<One> angle = atan2(Quantity<Metre>(1.0, 0.0), Quantity<Millimetre>(1000.0, 0.0));
+    ASSERT_NEAR(angle.value(), M_PI/4, ABSMAX);
+    Quantity<One> s = sin(Quantity<Metre>(1.0, 0.01)/Quantity<Metre>(2.0, 0.0));
+    EV expected = sin(EV(1.0, 0.01)/EV(2.0, 0.0));
+    ASSERT_NEAR(s.value(), expected.value, ABSMAX);
+    ASSERT_NEAR(s.error(), expected.error, ABSMAX);
+    // Percent is converted to a pure number before the function
+    ASSERT_NEAR(exp(Quantity<Percent>(100.0, 0.0)).value(), std::exp(1.0), ABSMAX);
+
+    Quantity<Joule> w = fma(Quantity<Newton>(2.0, 0.0), Quantity<Metre>(3.0, 0.0), Quantity<Kilojoule>(0.001, 0.0));
+    ASSERT_NEAR(w.value(), 7, ABSMAX);
+
+    Quantity<Millisecond, float> ms(16.0f, 0.8f);
+    Quantity<Second, float> root = sqrt(Quantity<UnitProduct<Second, Second>, float>(ms*ms.in<Second>()));
+    ASSERT_NEAR(root.value(), 0.016f, ABSMAX);
+}
+
+TEST(UnitsTests, ScalarsAndOutput) {
+    Quantity<Metre> a(2.0, 0.1);
+    Quantity<Metre> b = 3.0*a;
+    ASSERT_NEAR(b.value(), 6, ABSMAX);
+    ASSERT_NEAR((a/2.0).value(), 1, ABSMAX);
+    Quantity<UnitQuotient<One, Metre>> inverse = 1.0/a;
+    ASSERT_NEAR(inverse.value(), 0.5, ABSMAX);
+    ASSERT_NEAR((-a).value(), -2, ABSMAX);
+
+    std::ostringstream os;
+    os << Quantity<Joule>(1.0, 0.5);
+    ASSERT_NE(os.str().find("m^2 kg s^-2"), std::string::npos);
+    ASSERT_EQ(symbol<Kilometre>(), "1000 m");
+    ASSERT_EQ(symbol<One>(), "");
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
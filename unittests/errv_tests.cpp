@@ -245,6 +245,15 @@ TEST(ErrorValueComparisonOperators, DefaultComparisonOperator) {
     ASSERT_FALSE(d > c);
 }
 
+TEST(ErrorValueComparisonOperators, ConstEqualityDoesNotAssign) {
+    const ErrorValue a(10.2, 12.4), b(10.1, 0.12);
+
+    ASSERT_FALSE(a == b);
+    ASSERT_TRUE(a != b);
+    ASSERT_TRUE(b < a);
+    ASSERT_NEAR(a.value, 10.2, ABSMAX);
+}
+
 TEST(ErrorValueMemberOperators, MemberOperator) {
     ErrorValue a(10.2, 12.4);
     ASSERT_NEAR(a[0], 10.2, ABSMAX );
@@ -0,0 +1,51 @@
+/**
+ * This file is part of liberrc.
+ *
+ *  liberrc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of
+ *  the License, or (at your option) any later version.
+ *
+ *  liberrc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with liberrc.  If not,
+ *  see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBERRC_TEST_DATA_H
+#define LIBERRC_TEST_DATA_H
+
+// Deterministic test data, the same on every run and platform without a seeded generator
+
+#include <cmath>
+#include <cstddef>
+
+#include "errc_batch.h"
+
+// Scatter in [-1, 1]
+inline double noise(std::size_t i) {
+    return std::sin(12.9898*i)*0.5 + std::cos(78.233*i)*0.5;
+}
+
+// Scatter in [0, 1)
+inline double uniform(std::size_t i) {
+    double x = std::sin(12.9898*i + 1)*43758.5453;
+    return x - std::floor(x);
+}
+
+// Array of n elements, f(i) returns an ErrorValue of any types for element i
+template <typename T, typename F>
+liberrc::ErrorArray<T> generateArray(std::size_t n, F f) {
+    liberrc::ErrorArray<T> x(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        auto v = f(i);
+        x.set(i, static_cast<T>(v.value), static_cast<T>(v.error));
+    }
+    return x;
+}
+
+#endif //LIBERRC_TEST_DATA_H